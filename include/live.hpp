@@ -0,0 +1,123 @@
+// describes the packets that live telemetry is streamed over uart2 in
+// this is shared with the host-side receiver in tools/, so it shouldn't
+//  depend on anything from PROS
+//
+// before it's framed, a packet is:
+//  - bytes 0-1 are a sequence number that goes up by one for every packet,
+//    even ones that got dropped, so the receiver can tell what it missed
+//  - bytes 2-5 are millis() when the values were read
+//  - bytes 6-7 are a mask of the channels that are in the packet
+//  - then a 32 bit value for each channel in the mask, lowest channel first
+//  - then the CRC of everything before it
+// all of that is little endian
+// the packet is COBS encoded so it doesn't have any 0 bytes in it, and then
+//  a 0 is sent after it to mark where it ends
+
+#ifndef LIVE_HPP
+#define LIVE_HPP
+
+#define LIVE_HEADER_SIZE 8
+#define LIVE_VALUE_SIZE 4
+#define LIVE_CRC_SIZE 2
+// the most a packet can be before and after it's framed
+#define LIVE_MAX_CHANNELS 16
+#define LIVE_PACKET_SIZE \
+    (LIVE_HEADER_SIZE + LIVE_MAX_CHANNELS * LIVE_VALUE_SIZE + LIVE_CRC_SIZE)
+// COBS adds a byte every 254 bytes plus one, and then there's the 0
+#define LIVE_FRAME_SIZE (LIVE_PACKET_SIZE + LIVE_PACKET_SIZE / 254 + 2)
+
+namespace live
+{
+// what can be streamed
+enum Channel
+{
+    // drive train IME counts
+    CHANNEL_LEFT,
+    CHANNEL_RIGHT,
+    // lift position, see LIFT_UNIT_SHIFT
+    CHANNEL_LIFT,
+    // odometry pose, in 1/16 inches and 1/(1 << HEADING_SHIFT)ths of a
+    //  rotation
+    CHANNEL_X,
+    CHANNEL_Y,
+    CHANNEL_HEADING,
+    // filtered main battery voltage in mV
+    CHANNEL_BATTERY,
+    CHANNEL_COUNT
+};
+
+// CRC-16/CCITT (polynomial 0x1021, starts at 0xffff)
+inline unsigned int crc16(const unsigned char* data, unsigned int size)
+{
+    unsigned int crc = 0xffff;
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        crc ^= data[i] << 8;
+        for (unsigned int bit = 0; bit < 8; ++bit)
+        {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+        crc &= 0xffff;
+    }
+    return crc;
+}
+
+// COBS encodes size bytes, returns the amount of bytes in out (which
+//  doesn't include the 0 at the end)
+inline unsigned int encode(const unsigned char* in, unsigned int size,
+    unsigned char* out)
+{
+    // where the count of non-zero bytes before the next 0 goes
+    unsigned int code = 0;
+    unsigned int length = 1;
+    unsigned char count = 1;
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        if (in[i] != 0)
+        {
+            out[length++] = in[i];
+            ++count;
+        }
+        if (in[i] == 0 || count == 0xff)
+        {
+            out[code] = count;
+            code = length++;
+            count = 1;
+        }
+    }
+    out[code] = count;
+    return length;
+}
+
+// undoes encode(), returns false if the bytes aren't valid COBS
+inline bool decode(const unsigned char* in, unsigned int size,
+    unsigned char* out, unsigned int& length)
+{
+    length = 0;
+    unsigned int i = 0;
+    while (i < size)
+    {
+        unsigned char count = in[i++];
+        if (count == 0 || i + count - 1 > size)
+        {
+            return false;
+        }
+        for (unsigned int j = 1; j < count; ++j)
+        {
+            if (in[i] == 0)
+            {
+                return false;
+            }
+            out[length++] = in[i++];
+        }
+        // a full block doesn't stand for a 0, and neither does the last one
+        if (count != 0xff && i < size)
+        {
+            out[length++] = 0;
+        }
+    }
+    return true;
+}
+} // end namespace live
+
+#endif // LIVE_HPP
@@ -6,6 +6,7 @@
 
 #include <API.h>
 #include <math.h>
+#include <string.h>
 
 // general info
 #define TEAM_NAME "1516B"
@@ -13,6 +14,211 @@
 
 // time it takes for a motor to be updated in milliseconds
 #define MOTOR_POLL_RATE 20
+// amount of motor ports on the cortex
+#define PORT_COUNT 10
+// how often the odometry is updated in milliseconds
+#define ODOM_RATE 5
+
+// robot dimensions, distances are in 1/16 inches
+#define WHEEL_RADIUS 32ul
+#define BOT_RADIUS 120ul
+#define COUNTS_PER_REV_TORQUE 627.2 // IME counts per rev in high torque mode
+
+#include "units.hpp"
+#include "live.hpp"
+#include "path.hpp"
+
+// lock-free ways for tasks to share state, since taking a mutex for every
+//  access lets a low priority task hold up a high priority one
+namespace shared
+{
+// lets one task publish a value that other tasks can read without ever
+//  seeing half of an old value and half of a new one
+// the writer has to have at least as high a priority as every reader, or a
+//  reader could interrupt it in the middle of a write and spin forever
+template <typename T>
+class Seqlock
+{
+public:
+    Seqlock(): sequence(0), value() {}
+
+    // only one task can ever call this
+    void write(const T& newValue)
+    {
+        // odd while the value is being written so readers know to try again
+        ++sequence;
+        __sync_synchronize();
+        value = newValue;
+        __sync_synchronize();
+        ++sequence;
+    }
+
+    T read() const
+    {
+        T copy;
+        unsigned long before;
+        do
+        {
+            before = sequence;
+            __sync_synchronize();
+            copy = value;
+            __sync_synchronize();
+        }
+        while ((before & 1) || before != sequence);
+        return copy;
+    }
+
+private:
+    volatile unsigned long sequence;
+    T value;
+};
+
+// fractional bits in a Target's value
+#define TARGET_SHIFT 8
+
+// a setpoint that any task can set or read, kept in one word along with how
+//  many times it's been set so both are always read and written together
+class Target
+{
+public:
+    Target();
+
+    // value gets clamped to fit in the 16 bits it's kept in, so anything
+    //  outside of -128 to 127 won't come back out the same
+    void set(double value);
+    double get() const;
+    // gets the value along with the generation it was set in
+    double get(unsigned int& generation) const;
+    // same, but in 1/(1 << TARGET_SHIFT)ths without any floating point math
+    long getFixed(unsigned int& generation) const;
+    // changes every time the target is set, even if it's set to the same
+    //  value, so readers can tell when there's a new target
+    unsigned int getGeneration() const;
+
+private:
+    // generation in the high half, fixed point value in the low half
+    volatile unsigned long word;
+};
+} // end namespace shared
+
+// runs all the periodic sensing, control and output work in one task, in the
+//  same order every tick
+namespace exec
+{
+// every job's period is a multiple of this many ms
+#define EXEC_TICK 5
+#define MAX_JOBS 8
+
+// every tick the jobs run in phase order, then by priority within a phase
+enum Phase
+{
+    // reading the sensors
+    SENSE,
+    // working out what the motors should do
+    CONTROL,
+    // writing the motors
+    ACTUATE,
+    // anything that only shows what's going on
+    REPORT
+};
+
+// how long a job has been taking, times are in microseconds
+struct JobStats
+{
+    unsigned long runs;
+    unsigned long lastTime;
+    unsigned long maxTime;
+    unsigned long totalTime;
+};
+
+typedef void (*Job)();
+
+// adds a job that runs on every tick where tick % period == offset, jobs
+//  with the same phase and priority run in the order they were added
+// has to be done before the executor starts, returns false if there's no
+//  room for it
+bool add(const char* name, Job job, Phase phase, unsigned int priority,
+    unsigned int period, unsigned int offset);
+// runs the jobs forever, should be run in its own task
+void run(void*);
+// amount of ticks since the executor started
+unsigned long getTick();
+// time (in ms) that the current tick was supposed to start at
+unsigned long getTime();
+unsigned int getJobCount();
+// jobs are indexed in the order they run in
+const char* getJobName(unsigned int index);
+JobStats getJobStats(unsigned int index);
+} // end namespace exec
+
+// measures how well periodic loops keep to their periods
+namespace timing
+{
+#define TIMING_BINS 8
+// most loops that can be timed
+#define MAX_LOOP_TIMERS 12
+
+// amount of iterations that landed in each bin, see LoopTimer for the bins
+typedef unsigned long Histogram[TIMING_BINS];
+
+// times every iteration of a loop with micros(), which costs two micros()
+//  calls and a few adds per iteration
+// periods are binned from 0 to twice the nominal period and execution times
+//  from 0 to the nominal period, both linearly, jitter is binned in powers
+//  of 2 starting at 64us, and the last bin of each also holds anything bigger
+// only the loop's own task should call start() and stop(), anything else is
+//  only meant for showing what's going on
+class LoopTimer
+{
+public:
+    // period is in ms, the timer is registered so it shows up in dump()
+    LoopTimer(const char* name, unsigned long period);
+
+    // should be called right before the loop is entered, so the time since
+    //  it was last left doesn't count as a period
+    void enter();
+    // should be called at the start of every iteration
+    void start();
+    // should be called at the end of every iteration, before waiting
+    void stop();
+
+    const char* getName() const;
+    unsigned long getRuns() const;
+    // iterations that started more than a quarter of a period late, which
+    //  includes every iteration after one that took longer than the period
+    unsigned long getMisses() const;
+    // in microseconds
+    unsigned long getMaxJitter() const;
+    unsigned long getMaxExecTime() const;
+    // prints the histograms to stdout
+    void dump() const;
+
+private:
+    const char* name;
+    // in microseconds
+    unsigned long period;
+    unsigned long lastStart;
+    // whether lastStart is from the current run of the loop
+    bool entered;
+    unsigned long runs;
+    unsigned long misses;
+    unsigned long maxJitter;
+    unsigned long maxExecTime;
+    Histogram periods;
+    Histogram execTimes;
+    Histogram jitters;
+};
+
+// every LoopTimer that's been made, in the order they were made
+unsigned int getTimerCount();
+const LoopTimer* getTimer(unsigned int index);
+// prints every timer's histograms to stdout
+void dump();
+// has dumper() do a dump(), for loops that can't spend that long printing
+void requestDump();
+// task that does the dumps that were asked for, should be low priority
+void dumper(void*);
+} // end namespace timing
 
 // stuff that has to do with autonomous
 namespace auton
@@ -25,24 +231,300 @@ enum AutonID
     MG_CONE_LEFT,
     MG_CONE_RIGHT,
     SCORE_STATIONARY,
-    AUTONID_MAX = SCORE_STATIONARY
+    // plays back the last recording of the driver
+    REPLAY_DRIVER,
+    // runs the script picked by scriptid
+    SCRIPT,
+    AUTONID_MAX = SCRIPT
 };
 
 // determines what autonomous program to run
 extern AutonID autonid;
+// determines which script to run if autonid is SCRIPT
+extern unsigned int scriptid;
 } // end namespace auto
 
 namespace lcd
 {
-// controls the lcd screen
-void controller(void*);
+// how often the lcd is updated in milliseconds
+#define LCD_RATE 100
+
+// how much work the lcd is doing
+struct Stats
+{
+    // bytes sent over the UART, and how many would've been sent if every
+    //  line got sent every tick
+    unsigned long bytesSent;
+    unsigned long bytesWithoutDiff;
+    // CPU time the last tick took and the longest any tick took, in us
+    unsigned long lastTickTime;
+    unsigned long maxTickTime;
+};
+
+void init();
+// polls the buttons and redraws the screen, should be run every LCD_RATE
+void update();
+Stats getStats();
 } // end namespace lcd
 
 // stuff that has to do with motors
 namespace motor
 {
+// how often and how hard a MotorFrame had to hold its outputs back
+struct OutputStats
+{
+    // amount of port outputs that were cut down by their slew rate
+    unsigned long slewLimited;
+    // amount of flushes that went over the current budget
+    unsigned long governed;
+    // how much the outputs were scaled down by in the worst flush, in percent
+    unsigned int minScale;
+    // modeled current draw (mA) that the last flush asked for, and the most
+    //  that any flush asked for, before the budget was applied
+    unsigned long lastCurrent;
+    unsigned long peakCurrent;
+};
+
+// stages the outputs of every motor port so they can all be written at once
+// on the way out compensated ports get scaled to what they'd be on a 7.2V
+//  battery, every port is slew limited, then all of them get scaled down
+//  together if the motors would pull more current than the budget allows
+class MotorFrame
+{
+public:
+    // bit n of invertedPorts should be set if port n's motor is backwards
+    explicit MotorFrame(unsigned int invertedPorts);
+
+    // sets what a port should output on the next flush
+    void set(unsigned char port, int speed);
+    // sets between these two all go out in the same flush, since a flush
+    //  that happened halfway through setting a group would send its motors
+    //  different speeds, e.g. the two sides of the lift fighting each other
+    // a flush that lands in between goes with the last finished set of
+    //  outputs instead, any task can do this and they can overlap
+    void beginWrite();
+    void endWrite();
+    // gets what a port will output on the next flush, before inversion
+    int get(unsigned char port) const;
+    // gets what a port output on the last flush, before inversion
+    int getOutput(unsigned char port) const;
+    // writes every port whose output changed since the last flush
+    void flush();
+    // amount of writes the last flush skipped because they weren't needed
+    unsigned int getWritesSaved() const;
+    // amount of writes skipped since the frame was created
+    unsigned long getTotalWritesSaved() const;
+
+    // the most a port's output can go up by (away from 0) in one flush, 0
+    //  means no limit
+    // slowing down and stopping happen right away
+    void setSlewRate(unsigned char port, int rate);
+    // how many motors are plugged into a port, e.g. with a y-cable
+    void setMotorCount(unsigned char port, unsigned int count);
+    // how fast (rpm) a port's motors are going, positive being the direction
+    //  of a positive set(), which the current model needs
+    void setSpeed(unsigned char port, int rpm);
+    // whether a port's output should be scaled for the battery voltage, so
+    //  it goes the same speed no matter how charged the battery is
+    void setCompensated(unsigned char port, bool compensated);
+    // filtered battery voltage (mV) that the outputs are compensated with
+    unsigned int getBattery() const;
+    // the most current (mA) all the motors together are allowed to pull, 0
+    //  means no limit
+    void setCurrentBudget(unsigned long budget);
+    OutputStats getOutputStats() const;
+
+private:
+    // takes a new battery sample every few flushes
+    void sampleBattery();
+    // scales an output to what it'd be on a nominal battery
+    int compensate(unsigned char port, int output) const;
+    // slew limits a port's output when it's speeding up
+    int slew(unsigned char port, int output);
+    // modeled current (mA) a port would pull with a certain output
+    unsigned long getCurrent(unsigned char port, int output,
+        unsigned int voltage) const;
+    // scales the outputs down if they'd go over the current budget
+    void govern(int* outputs);
+
+    unsigned int invertedPorts;
+    // indexed by port - 1
+    volatile int staged[PORT_COUNT];
+    // what staged[] was the last time no write was going on, which is what
+    //  gets flushed
+    int committed[PORT_COUNT];
+    // amount of writes going on, and how many have finished
+    volatile unsigned int writing;
+    volatile unsigned long finished;
+    int written[PORT_COUNT];
+    // whether written[] can't be trusted, e.g. after the robot was disabled
+    bool stale;
+    // amount of set() calls since the last flush
+    volatile unsigned int sets;
+    unsigned int writesSaved;
+    unsigned long totalWritesSaved;
+    // what was actually output on the last flush, before inversion
+    int applied[PORT_COUNT];
+    int slewRates[PORT_COUNT];
+    unsigned int motorCounts[PORT_COUNT];
+    volatile int speeds[PORT_COUNT];
+    unsigned long currentBudget;
+    OutputStats outputStats;
+    // bit n is set if port n is compensated
+    unsigned int compensatedPorts;
+    // powerLevelMain() goes through the ADC and dips whenever the motors
+    //  pull a lot of current, so it's sampled slowly and filtered
+    unsigned int battery;
+    unsigned int flushesUntilSample;
+};
+
+// compile time helpers for MotorGroup, they take ports the same way it does
+constexpr unsigned char getPortNumber(int port)
+{
+    return port < 0 ? -port : port;
+}
+
+constexpr unsigned int portBit(int port)
+{
+    return 1u << getPortNumber(port);
+}
+
+constexpr bool arePortsValid()
+{
+    return true;
+}
+
+template <typename... Ports>
+constexpr bool arePortsValid(int port, Ports... ports)
+{
+    return port != 0 && port >= -PORT_COUNT && port <= PORT_COUNT &&
+        arePortsValid(ports...);
+}
+
+// bit n is set if port n is one of the ports
+constexpr unsigned int getPortMask()
+{
+    return 0;
+}
+
+template <typename... Ports>
+constexpr unsigned int getPortMask(int port, Ports... ports)
+{
+    return portBit(port) | getPortMask(ports...);
+}
+
+// bit n is set if port n is one of the ports and is backwards
+constexpr unsigned int getInvertedMask()
+{
+    return 0;
+}
+
+template <typename... Ports>
+constexpr unsigned int getInvertedMask(int port, Ports... ports)
+{
+    return (port < 0 ? portBit(port) : 0) | getInvertedMask(ports...);
+}
+
+// whether no port is given twice, even with different directions
+constexpr bool arePortsUnique()
+{
+    return true;
+}
+
+template <typename... Ports>
+constexpr bool arePortsUnique(int port, Ports... ports)
+{
+    return (getPortMask(ports...) & portBit(port)) == 0 &&
+        arePortsUnique(ports...);
+}
+
+// whether none of the port masks have a port in common
+constexpr bool areMasksDisjoint(unsigned int)
+{
+    return true;
+}
+
+template <typename... Masks>
+constexpr bool areMasksDisjoint(unsigned int first, unsigned int second,
+    Masks... masks)
+{
+    return (first & second) == 0 && areMasksDisjoint(first | second, masks...);
+}
+
+// motors that always get driven together, a port is negative if its motor
+//  is wired backwards, e.g. MotorGroup<2, -9> runs port 9 in reverse
+// everything about a group is worked out at compile time, so setting one is
+//  the same as setting each of its ports by hand
+template <int... Port>
+class MotorGroup
+{
+    static_assert(sizeof...(Port) > 0, "a motor group needs a port");
+    static_assert(arePortsValid(Port...), "motor ports go from 1 to 10");
+    static_assert(arePortsUnique(Port...), "a port is in a motor group twice");
+
+public:
+    // bit n is set if port n is in the group
+    static constexpr unsigned int getPorts()
+    {
+        return getPortMask(Port...);
+    }
+
+    // bit n is set if port n is in the group and is backwards, the frame
+    //  the group is set on should be made with this
+    static constexpr unsigned int getInverted()
+    {
+        return getInvertedMask(Port...);
+    }
+
+    // stages the same speed for every motor in the group
+    static void set(MotorFrame& frame, int speed)
+    {
+        frame.beginWrite();
+        // expands to one frame.set() per port
+        int unused[] = {(frame.set(getPortNumber(Port), speed), 0)...};
+        (void) unused;
+        frame.endWrite();
+    }
+
+    // see the MotorFrame functions with the same names
+    static void setSlewRate(MotorFrame& frame, int rate)
+    {
+        int unused[] = {(frame.setSlewRate(getPortNumber(Port), rate), 0)...};
+        (void) unused;
+    }
+
+    static void setMotorCount(MotorFrame& frame, unsigned int count)
+    {
+        int unused[] =
+            {(frame.setMotorCount(getPortNumber(Port), count), 0)...};
+        (void) unused;
+    }
+
+    static void setSpeed(MotorFrame& frame, int rpm)
+    {
+        int unused[] = {(frame.setSpeed(getPortNumber(Port), rpm), 0)...};
+        (void) unused;
+    }
+
+    static void setCompensated(MotorFrame& frame, bool compensated)
+    {
+        int unused[] =
+            {(frame.setCompensated(getPortNumber(Port), compensated), 0)...};
+        (void) unused;
+    }
+};
+
 // does motor initialization stuff
 void init();
+// samples the drive train IMEs and updates the odometry, and samples all the
+//  IMEs every MOTOR_POLL_RATE, should be run every ODOM_RATE
+void sense();
+// writes the motor frame, should be run every MOTOR_POLL_RATE
+void flush();
+// gets the time (in ms) the IME readings that the getters use were taken
+unsigned long getSampleTime();
+// gets the frame that all the motor outputs are staged in
+const MotorFrame& getFrame();
 
 // indicates a motor direction
 enum Direction
@@ -59,22 +541,55 @@ enum Direction
     BACKWARD = -1
 };
 
+// how well the lift controller did at getting to its last target
+struct LiftStats
+{
+    // time it took to settle in ms, or 0 if it hasn't settled yet
+    unsigned long settleTime;
+    // how far the lift went past the target, in position units
+    double overshoot;
+    // amount of targets the lift has settled at
+    unsigned long moves;
+};
+
 // cone lift functions
 // max=127, min=0
 double getLiftPos();
+// same as getLiftPos(), but without any floating point math
+units::LiftUnits getLiftPosition();
+// in position units per second
+double getLiftVelocity();
 double getLiftTarget();
+// makes the lift controller hold the lift at a position
 void setLiftTarget(double targetPos);
+// drives the lift directly, which turns off the lift controller
 void setLift(int drive);
+// moves the lift towards the lift target, should be run every
+//  MOTOR_POLL_RATE
+void controlLift();
+// checks if the lift controller has the lift at its target
+bool isLiftSettled();
+// waits until the lift settles, returns false if it took longer than timeout
+bool waitForLift(unsigned long timeout);
+LiftStats getLiftStats();
 
 // mobile goal lift functions
 double getMglPos();
+double getMglVelocity();
 double getMglTarget();
 void setMglTarget(double targetPos);
 void setMgl(int drive);
 
-double getLeftRotations();
-double getRightRotations();
-void resetDT();
+// how far each side has gone since the robot turned on
+units::Counts getLeftCounts();
+units::Counts getRightCounts();
+// in rotations per second
+double getLeftVelocity();
+double getRightVelocity();
+// how fast each side is going in 1/16 inches per second, without any
+//  floating point math
+long getLeftSpeed();
+long getRightSpeed();
 void setLeftDriveTrain(int speed);
 void setRightDriveTrain(int speed);
 
@@ -86,12 +601,476 @@ void setMobileGoalLift(Direction direction);
 
 namespace sensor
 {
+// the last time the lift hit its limit switch
+struct LiftContact
+{
+    // how many times it's been hit since the robot turned on
+    unsigned long contacts;
+    // micros() at the moment it was hit
+    unsigned long time;
+};
+
 // initializes all sensors, should be run in initializeIO
 void init();
-// checks if the lift is fully down
+// calibrates the gyro, should be run in initialize() while the robot is
+//  sitting still
+void initGyro();
+bool hasGyro();
+// how far the robot has turned since initGyro(), counterclockwise in
+//  HEADING_PER_REV units like the odometry
+long getGyroHeading();
+// checks if the lift is fully down, which only reads a flag that the limit
+//  switch's interrupt keeps up to date
 bool isLiftDown();
+LiftContact getLiftContact();
 } // end namespace sensor
 
+// keeps track of the robot's position on the field
+namespace odom
+{
+// positions are in 1/16 inches << POSE_SHIFT
+#define POSE_SHIFT 16
+// headings are counterclockwise in 1/(1 << HEADING_SHIFT)ths of a rotation
+#define HEADING_SHIFT 24
+#define HEADING_PER_REV (1l << HEADING_SHIFT)
+
+// where the robot is and which way it's facing, x is forwards at heading 0
+struct Pose
+{
+    long x;
+    long y;
+    // not wrapped around, so it keeps counting up after a full turn
+    long heading;
+    // when the pose was last updated
+    unsigned long time;
+};
+
+// integrates the change in the drive train IME counts (positive = forwards)
+//  and pulls the heading towards the gyro's if there is one and it's been
+//  seen turning with the wheels
+// should only be called by motor::sense
+void update(int left, int right, unsigned long time);
+// gets the latest pose without blocking, can be called from any task
+Pose getPose();
+// whether the heading is following the gyro yet
+bool isGyroTrusted();
+// makes the odometry start from a certain pose on its next update, and waits
+//  for that update so getPose() gets it right away
+// can't be called from the executor, or before it's started
+void setPose(const Pose& pose);
+// converts pose units into something a bit more readable
+long toSixteenths(long position);
+long toDegrees(long heading);
+// gets sin(angle) << 14 without any floating point math, angle is in
+//  1/65536ths of a rotation (heading >> (HEADING_SHIFT - 16))
+long sin16(unsigned long angle);
+} // end namespace odom
+
+// the building blocks of autonomous routines
+namespace auton
+{
+// something autonomous does over a period of time, like driving or moving the
+//  lift, which can run at the same time as other actions
+// the autonomous task starts and cancels actions, and control() in the
+//  executor moves them along
+class Action
+{
+public:
+    Action();
+
+    // starts the action, cancelling it first if it's already running
+    void start();
+    // moves the action along, returns whether it's done, only control()
+    //  should call this
+    bool update();
+    // stops the action early
+    void cancel();
+    bool isRunning() const;
+    // how many times the action has been started, used by handles
+    unsigned long getGeneration() const;
+    // when (in ms) the last run of the action started
+    unsigned long getStartTime() const;
+    // how long the last run of the action took in ms
+    unsigned long getDuration() const;
+
+protected:
+    // called when the action starts
+    virtual void begin() = 0;
+    // called every tick with the ms since it started, returns true when done
+    virtual bool step(unsigned long elapsed) = 0;
+    // called when the action is done or gets cancelled
+    virtual void end();
+
+public:
+    // how long the action should be waited on before giving up, in ms
+    virtual unsigned long getBudget() const;
+    // how fast the part of the robot the action moves is going
+    virtual double getSpeed() const;
+    // going slower than this while running means it's stalled, or 0 if the
+    //  action can't tell or isn't pushing hard enough right now to tell,
+    //  like when it's slowing down to stop
+    virtual double getStallSpeed() const;
+
+private:
+    // stops the action if it's running, only once even if both tasks try
+    void finish();
+
+    volatile bool running;
+    volatile unsigned long generation;
+    unsigned long startTime;
+    unsigned long duration;
+};
+
+// refers to one run of an action so it can be waited on
+struct Handle
+{
+    Action* action;
+    unsigned long generation;
+};
+
+// checks if the run of the action a handle refers to is over
+bool isDone(Handle handle);
+
+// how a wait ended
+enum WaitResult
+{
+    WAIT_DONE,
+    // took longer than its budget
+    WAIT_TIMEOUT,
+    // the thing it was waiting on stopped moving
+    WAIT_STALLED
+};
+
+// how wait() can tell if something is stuck
+struct StallWatch
+{
+    // gets how fast it's moving, given arg
+    double (*speed)(void*);
+    // going slower than what this gets, given arg, unless it's 0...
+    double (*minSpeed)(void*);
+    void* arg;
+    // ...for this many ms counts as stalled
+    unsigned long time;
+};
+
+// how long a wait took compared to how long it was allowed to take
+struct WaitRecord
+{
+    unsigned long budget;
+    unsigned long took;
+    WaitResult result;
+};
+
+// how far a straight() drive ended up from the line it started on, going by
+//  the odometry, all in 1/16 inches
+struct DriftRecord
+{
+    // how far it went along the line
+    long distance;
+    // how far to the left of the line it ended up, and the furthest it got
+    //  from it on either side
+    long drift;
+    long maxDrift;
+    // how far it ended up turned counterclockwise, in degrees
+    double headingError;
+};
+
+// makes what the actions need, should be run in initialize()
+void init();
+// moves every running action along, should be run every MOTOR_POLL_RATE in
+//  the CONTROL phase
+void control();
+
+typedef bool (*Predicate)(void*);
+// blocks while the executor runs the actions, until done(arg) is true,
+//  budget ms pass, or stall says it's stuck (stall can be NULL)
+WaitResult wait(Predicate done, void* arg, unsigned long budget,
+    const StallWatch* stall);
+
+// these all start an action and return right away
+// dt functions require a stop() at the end to allow chaining
+Handle straight(unsigned long distance, int power);
+Handle turnCW(unsigned int angle, int turnRadius, int leftPower);
+Handle turnCCW(unsigned int angle, int turnRadius, int rightPower);
+// drives along a path from tools/paths.txt, mirrored to the other side of
+//  the field if mirror is set, power < 0 drives it backwards
+Handle follow(unsigned int index, int power, bool mirror);
+Handle follow(const char* name, int power, bool mirror);
+Handle lift(double target); // max=127, min=0
+Handle claw(motor::Direction direction);
+Handle mgl(double target);
+// stops the drive train right away
+void stop();
+
+// waits until an action is done, while it and any other running actions
+//  keep going in the executor
+// if the action times out or stalls it gets cancelled
+WaitResult await(Handle handle);
+// waits until both actions are done
+WaitResult join(Handle a, Handle b);
+// waits until an action is done or timeout ms have passed, returns whether
+//  the action finished first
+bool race(Handle handle, unsigned long timeout);
+
+// should be called around every routine, endRoutine() waits for any actions
+//  that are still running, for no longer than their budgets or the rest of
+//  the period, cancels whatever still hasn't finished, then prints how much
+//  time running them at the same time saved
+void beginRoutine();
+void endRoutine(const char* name);
+// gets every wait since the routine started, up to a limit
+const WaitRecord* getWaitLog(unsigned int* count);
+// gets every straight() drive since the routine started, up to a limit
+const DriftRecord* getDriftLog(unsigned int* count);
+
+// looks for script files on the cortex, should be run in initialize()
+void findScripts();
+unsigned int getScriptCount();
+const char* getScriptName(unsigned int index);
+// loads and runs a script, returns false if it couldn't be loaded
+bool runScript(unsigned int index);
+} // end namespace auton
+
+// stuff that has to do with driver input
+namespace input
+{
+// the file recordings are saved to
+#define RECORD_FILE "record"
+// a recording can't be bigger than this, in bytes
+#define RECORD_MAX_SIZE 32768ul
+// each tick of a recording takes at most 1 header byte, AXIS_COUNT axis bytes,
+//  and 2 button bytes, so at 50 ticks per second a recording can never use
+//  more than this many bytes per second
+#define RECORD_BUDGET (6 * 1000 / MOTOR_POLL_RATE)
+
+// each button the driver uses
+enum Button
+{
+    BTN_5U = 1 << 0,
+    BTN_5D = 1 << 1,
+    BTN_6U = 1 << 2,
+    BTN_6D = 1 << 3,
+    BTN_7L = 1 << 4,
+    BTN_7U = 1 << 5,
+    BTN_8U = 1 << 6,
+    BTN_8D = 1 << 7,
+    BTN_8L = 1 << 8,
+    BTN_8R = 1 << 9,
+    BUTTON_COUNT = 10
+};
+
+// amount of joystick axes that get read (axes 1 through 3)
+#define AXIS_COUNT 3
+
+// what the joystick is doing during one tick
+struct State
+{
+    // axes[0] is axis 1, already thresholded
+    signed char axes[AXIS_COUNT];
+    unsigned short buttons;
+
+    bool pressed(Button button) const
+    {
+        return buttons & button;
+    }
+};
+
+// how recording and playback went
+struct StreamStats
+{
+    // amount of ticks and bytes recorded or played
+    unsigned long ticks;
+    unsigned long bytes;
+    // longest a file read (in the streamer task) or a play() call (in the
+    //  control loop) took, in microseconds
+    unsigned long maxReadTime;
+    unsigned long maxPlayTime;
+    // times play() had to reuse the last state because data wasn't ready
+    unsigned long underruns;
+    // bytes that didn't fit in the recording buffer
+    unsigned long dropped;
+};
+
+// moves recordings between the file system and memory so the control loop
+//  never has to wait on a file, should be run in its own low priority task
+void streamer(void*);
+
+// starts recording the driver to RECORD_FILE, replacing what was there
+// the streamer opens the file, so this never waits on the file system, and
+//  it only returns false if something's already being recorded or played
+bool startRecording();
+// the streamer writes out the rest and closes the file on its next run
+void stopRecording();
+bool isRecording();
+// adds a tick to the recording, does nothing if it isn't recording
+void record(const State& state);
+
+// starts playing RECORD_FILE back, returns false if there isn't one
+bool startPlayback();
+// gets the state for the next tick, returns false when the recording is over
+bool play(State* state);
+// the streamer closes the file on its next run, and nothing new can be
+//  recorded or played until it has
+void stopPlayback();
+// makes what update() and replay() need, should be run in initialize()
+void init();
+// drives the robot from the joystick during operator control, or from the
+//  recording during replay(), should be run every MOTOR_POLL_RATE in the
+//  CONTROL phase
+void update();
+// drives the robot from the recording like the driver did, used in
+//  autonomous, and waits until it's over
+void replay();
+
+StreamStats getStreamStats();
+} // end namespace input
+
+// logs what the robot is doing to flash so it can be looked at after a match
+//  (see include/telemetry.hpp for the format and tools/ for the decoder)
+namespace telemetry
+{
+// the files that logs go in, one for each part of the match
+#define TELEMETRY_AUTON_FILE "telema"
+#define TELEMETRY_DRIVER_FILE "telemd"
+// a log can't be bigger than this, in bytes
+#define TELEMETRY_MAX_SIZE 65536ul
+
+// how the logging is going
+struct Stats
+{
+    // records that were logged, and that were dropped because the buffer or
+    //  the file was full
+    unsigned long records;
+    unsigned long dropped;
+    // bytes written to the file and the amount of fwrite() calls it took
+    unsigned long bytes;
+    unsigned long writes;
+    // longest an fwrite() took, in microseconds
+    unsigned long maxWriteTime;
+};
+
+// starts a new log in a file, replacing what was there
+// the writer task opens the file, so this never waits on the file system
+void start(const char* file);
+// ends the log, which also happens when the robot gets disabled
+void stop();
+
+// these add a record if there's a log going and it's been long enough since
+//  the last one of their type, and they never wait
+// only one task should be logging each type of record
+void logImes(const int* counts);
+// takes the outputs of ports 1 to PORT_COUNT
+void logMotors(const int* outputs);
+void logJoystick(const input::State& state);
+// reads and logs the battery voltages, should be run every second or so
+void logBattery();
+
+// moves records from memory to the file, should be run in its own low
+//  priority task
+void writer(void*);
+Stats getStats();
+} // end namespace telemetry
+
+// streams what the robot is doing over uart2 while it's running (see
+//  include/live.hpp for the packets and tools/ for the receiver)
+namespace live
+{
+// how often values can be read, in ms
+#define LIVE_RATE MOTOR_POLL_RATE
+
+// how the stream is going
+struct Stats
+{
+    // packets made, and the ones that were dropped because the UART was
+    //  behind
+    unsigned long packets;
+    unsigned long dropped;
+    // bytes given to the UART and the amount of fwrite() calls it took
+    unsigned long bytes;
+    unsigned long writes;
+    // most bytes that were ever waiting to be sent
+    unsigned long maxBacklog;
+};
+
+// opens uart2, should be run in initialize()
+void init();
+// makes a channel get sent every decimation * LIVE_RATE ms, or never if
+//  decimation is 0
+void setDecimation(Channel channel, unsigned int decimation);
+// reads the channels that are due and queues a packet, never waits on the
+//  UART, should be run every LIVE_RATE
+void sample();
+// sends the queued packets, should be run in its own low priority task
+void sender(void*);
+Stats getStats();
+} // end namespace live
+
+// stuff that has to do with planning smooth motion
+namespace profile
+{
+// fractional bits the planned profile is kept in
+#define PROFILE_SHIFT 8
+
+// what a motion profile can't go over, all in units per second^n
+struct Limits
+{
+    double velocity;
+    double acceleration;
+    // 0 for no jerk limit, which makes the profile trapezoidal
+    double jerk;
+};
+
+// where something following a profile should be at a certain time, in whole
+//  units (per second^n)
+struct Setpoint
+{
+    long position;
+    long velocity;
+    long acceleration;
+};
+
+// S-curve (or trapezoidal) motion profile that goes from rest to rest
+class Profile
+{
+public:
+    Profile();
+
+    // figures out the whole profile, should only be done once per move
+    // distance can be negative to go backwards
+    void plan(double distance, const Limits& limits);
+    // gets the setpoint some amount of ms after the start, which is all
+    //  integer math so it can be done every tick
+    Setpoint at(unsigned long time) const;
+    // how long the profile takes in ms
+    unsigned long getDuration() const;
+
+private:
+    // the profile is made up of 7 phases with constant jerk:
+    // jerk up, constant acceleration, jerk down, cruise, and then the same
+    //  thing backwards to slow down
+    enum { SEGMENT_COUNT = 7 };
+    struct Segment
+    {
+        // when the segment starts in ms
+        unsigned long start;
+        // the polynomial the segment follows from its start, in units (per
+        //  second^n) << PROFILE_SHIFT, the acceleration and jerk are already
+        //  divided down so at() only has to multiply and shift
+        long position;
+        long velocity;
+        long halfAcceleration;
+        long sixthJerk;
+    };
+    Segment segments[SEGMENT_COUNT];
+    // 1 or -1 depending on which way the profile goes
+    long direction;
+    // where the profile ends up, in units
+    long distance;
+    // in ms
+    unsigned long duration;
+};
+} // end namespace profile
+
 // these last 4 functions down here are what PROS uses internally to do cool
 //  stuff so it's not recommended to call them within the actual code
 extern "C"
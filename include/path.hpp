@@ -0,0 +1,55 @@
+// describes the paths that auton::follow() drives along
+// this is shared with the host-side path generator in tools/, so it
+//  shouldn't depend on anything from PROS
+//
+// paths are written as waypoints in tools/paths.txt, and tools/pathc turns
+//  them into src/paths.cpp ahead of time: the corners get rounded off, the
+//  path gets split into points PATH_SPACING apart, and every point gets the
+//  fastest the robot can go there without sliding off the curve or being
+//  unable to stop at the end
+// that leaves the robot with just finding the nearest point and steering
+//  towards one further along
+
+#ifndef PATH_HPP
+#define PATH_HPP
+
+// distance between points, in 1/16 inches
+#define PATH_SPACING 16
+// the most points a path can have
+#define PATH_MAX_POINTS 1024
+// how fast the robot can go and speed up or slow down, in 1/16 inches per
+//  second (squared), same as DT_MAX_VELOCITY/DT_MAX_ACCEL in src/actions.cpp
+#define PATH_MAX_VELOCITY 300
+#define PATH_MAX_ACCEL 600
+// fastest the robot should turn while following a path, in rad/s, so it
+//  can't go faster than this times the radius of a curve
+#define PATH_MAX_TURN_RATE 1.5
+// radius of the arcs that the corners get rounded off with, unless the
+//  segments on either side of the corner are too short for it
+#define PATH_CORNER_RADIUS 192
+
+namespace path
+{
+// a point on the field, in the odometry's coordinates (1/16 inches, x is
+//  forwards from where the robot was when autonomous started)
+struct Point
+{
+    short x;
+    short y;
+    // fastest the robot should go at this point, in 1/16 inches per second
+    short speed;
+};
+
+struct Path
+{
+    const char* name;
+    const Point* points;
+    unsigned int size;
+};
+
+// every path from tools/paths.txt, in the same order
+extern const Path paths[];
+extern const unsigned int pathCount;
+} // end namespace path
+
+#endif // PATH_HPP
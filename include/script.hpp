@@ -0,0 +1,103 @@
+// describes the binary format of autonomous scripts
+// this is shared with the host-side compiler in tools/, so it shouldn't
+//  depend on anything from PROS
+
+#ifndef SCRIPT_HPP
+#define SCRIPT_HPP
+
+// every script starts with this, followed by the number of instructions as a
+//  little endian 16 bit integer, and then 2 unused bytes
+#define SCRIPT_MAGIC "AUT1"
+#define SCRIPT_HEADER_SIZE 8
+// every instruction is the same size so decoding one is constant time
+#define SCRIPT_INSTRUCTION_SIZE 8
+// the most instructions a script can have
+#define SCRIPT_MAX_INSTRUCTIONS 128
+// lift and mgl positions are fixed point with this many fractional bits
+#define SCRIPT_POS_SHIFT 8
+
+namespace script
+{
+enum Opcode
+{
+    // a = distance (1/16 in), arg = power (negative = backwards)
+    OP_DRIVE,
+    // a = angle (degrees), b = turn radius (1/16 in), arg = outside power
+    OP_TURN_CW,
+    OP_TURN_CCW,
+    // stops the drive train
+    OP_STOP,
+    // a = position << SCRIPT_POS_SHIFT
+    OP_LIFT,
+    // arg = motor::Direction
+    OP_CLAW,
+    // a = position << SCRIPT_POS_SHIFT
+    OP_MGL,
+    // a = time (ms)
+    OP_WAIT,
+    // a = amount of instructions after this one that run at the same time,
+    //  which all have to be actions
+    OP_PARALLEL,
+    // a = path index (order in tools/paths.txt), b = 1 to mirror it,
+    //  arg = power (negative = backwards)
+    OP_FOLLOW,
+    OPCODE_COUNT
+};
+
+// one decoded instruction
+struct Instruction
+{
+    unsigned char op;
+    signed char arg;
+    short a;
+    short b;
+    short c;
+};
+
+// whether an opcode starts something that runs over time and can be waited
+//  on, which is all that can go in a parallel block since anything else
+//  would happen right away and hold up the rest of the block
+inline bool isAction(unsigned char op)
+{
+    switch (op)
+    {
+    case OP_DRIVE:
+    case OP_TURN_CW:
+    case OP_TURN_CCW:
+    case OP_LIFT:
+    case OP_CLAW:
+    case OP_MGL:
+    case OP_FOLLOW:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// converts the 8 bytes of an instruction into an Instruction
+inline Instruction decode(const unsigned char* bytes)
+{
+    Instruction instruction;
+    instruction.op = bytes[0];
+    instruction.arg = (signed char) bytes[1];
+    instruction.a = (short) (bytes[2] | (bytes[3] << 8));
+    instruction.b = (short) (bytes[4] | (bytes[5] << 8));
+    instruction.c = (short) (bytes[6] | (bytes[7] << 8));
+    return instruction;
+}
+
+// converts an Instruction into 8 bytes
+inline void encode(const Instruction& instruction, unsigned char* bytes)
+{
+    bytes[0] = instruction.op;
+    bytes[1] = (unsigned char) instruction.arg;
+    bytes[2] = instruction.a & 0xff;
+    bytes[3] = (instruction.a >> 8) & 0xff;
+    bytes[4] = instruction.b & 0xff;
+    bytes[5] = (instruction.b >> 8) & 0xff;
+    bytes[6] = instruction.c & 0xff;
+    bytes[7] = (instruction.c >> 8) & 0xff;
+}
+} // end namespace script
+
+#endif // SCRIPT_HPP
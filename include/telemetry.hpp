@@ -0,0 +1,100 @@
+// describes the binary format of telemetry logs
+// this is shared with the host-side decoder in tools/, so it shouldn't
+//  depend on anything from PROS
+//
+// a log starts with TELEMETRY_MAGIC and millis() when the log was started
+//  as a little endian 32 bit integer, followed by records that are all
+//  TELEMETRY_RECORD_SIZE bytes:
+//  - bytes 0-1 are the ms since the last record (or the start of the log) as
+//    a signed little endian 16 bit integer, records can be a bit out of order
+//    since more than one task makes them
+//  - byte 2 is the RecordType, byte 3 is unused
+//  - the rest is the payload, which depends on the type
+
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#define TELEMETRY_MAGIC "TLM1"
+#define TELEMETRY_HEADER_SIZE 8
+#define TELEMETRY_RECORD_SIZE 20
+#define TELEMETRY_PAYLOAD_SIZE 16
+// amount of values in each type of record
+#define TELEMETRY_IMES 4
+#define TELEMETRY_PORTS 10
+#define TELEMETRY_AXES 3
+
+namespace telemetry
+{
+// multi-byte values in payloads are little endian
+enum RecordType
+{
+    // TELEMETRY_IMES raw IME counts, 32 bits each
+    RECORD_IMES,
+    // what each motor port (1 to TELEMETRY_PORTS) was set to, 8 bits each
+    RECORD_MOTORS,
+    // TELEMETRY_AXES joystick axes (8 bits each), then the input::Buttons
+    //  (16 bits)
+    RECORD_JOYSTICK,
+    // main battery, backup battery and the filtered main battery voltage
+    //  that motor outputs are compensated with, all in mV and 16 bits each
+    RECORD_BATTERY,
+    RECORD_TYPE_COUNT
+};
+
+// one decoded record
+struct Record
+{
+    short delta;
+    unsigned char type;
+    unsigned char payload[TELEMETRY_PAYLOAD_SIZE];
+};
+
+inline void putShort(unsigned char* bytes, unsigned int value)
+{
+    bytes[0] = value & 0xff;
+    bytes[1] = (value >> 8) & 0xff;
+}
+
+inline void putLong(unsigned char* bytes, unsigned long value)
+{
+    putShort(bytes, value & 0xffff);
+    putShort(bytes + 2, (value >> 16) & 0xffff);
+}
+
+inline unsigned int getShort(const unsigned char* bytes)
+{
+    return bytes[0] | (bytes[1] << 8);
+}
+
+inline unsigned long getLong(const unsigned char* bytes)
+{
+    return getShort(bytes) | ((unsigned long) getShort(bytes + 2) << 16);
+}
+
+// converts the TELEMETRY_RECORD_SIZE bytes of a record into a Record
+inline Record decode(const unsigned char* bytes)
+{
+    Record record;
+    record.delta = (short) getShort(bytes);
+    record.type = bytes[2];
+    for (unsigned int i = 0; i < TELEMETRY_PAYLOAD_SIZE; ++i)
+    {
+        record.payload[i] = bytes[4 + i];
+    }
+    return record;
+}
+
+// converts a Record into TELEMETRY_RECORD_SIZE bytes
+inline void encode(const Record& record, unsigned char* bytes)
+{
+    putShort(bytes, (unsigned short) record.delta);
+    bytes[2] = record.type;
+    bytes[3] = 0;
+    for (unsigned int i = 0; i < TELEMETRY_PAYLOAD_SIZE; ++i)
+    {
+        bytes[4 + i] = record.payload[i];
+    }
+}
+} // end namespace telemetry
+
+#endif // TELEMETRY_HPP
@@ -0,0 +1,149 @@
+// declares the units that positions and distances are kept in
+// every unit is a whole number of something, and converting from one unit to
+//  another is an integer multiply and shift by a factor that's worked out at
+//  compile time, so the conversions don't need the cortex's soft float
+//  library
+// the lift controller and the drive follower work in these the whole way
+//  through, doubles are only left where a position goes in or comes out of
+//  the API (like getLiftPos() and setLiftTarget())
+// main.hpp includes this after the robot's dimensions are defined
+
+#ifndef UNITS_HPP
+#define UNITS_HPP
+
+// conversion factors are fixed point with this many fractional bits
+#define UNITS_SHIFT 16
+// lift and mgl positions go from 0 to 127 in 1/(1 << LIFT_UNIT_SHIFT)ths
+#define LIFT_UNIT_SHIFT 8
+
+namespace units
+{
+// an amount of some unit, which can't be mixed up with any other unit
+template <typename Unit>
+class Quantity
+{
+public:
+    constexpr Quantity(): value(0) {}
+    constexpr explicit Quantity(long value): value(value) {}
+
+    constexpr long get() const
+    {
+        return value;
+    }
+
+    constexpr Quantity operator+(Quantity other) const
+    {
+        return Quantity(value + other.value);
+    }
+    constexpr Quantity operator-(Quantity other) const
+    {
+        return Quantity(value - other.value);
+    }
+    constexpr Quantity operator-() const
+    {
+        return Quantity(-value);
+    }
+    constexpr Quantity operator*(long scale) const
+    {
+        return Quantity(value * scale);
+    }
+    constexpr Quantity operator/(long scale) const
+    {
+        return Quantity(value / scale);
+    }
+    Quantity& operator+=(Quantity other)
+    {
+        value += other.value;
+        return *this;
+    }
+    Quantity& operator-=(Quantity other)
+    {
+        value -= other.value;
+        return *this;
+    }
+
+    constexpr bool operator==(Quantity other) const
+    {
+        return value == other.value;
+    }
+    constexpr bool operator!=(Quantity other) const
+    {
+        return value != other.value;
+    }
+    constexpr bool operator<(Quantity other) const
+    {
+        return value < other.value;
+    }
+    constexpr bool operator<=(Quantity other) const
+    {
+        return value <= other.value;
+    }
+    constexpr bool operator>(Quantity other) const
+    {
+        return value > other.value;
+    }
+    constexpr bool operator>=(Quantity other) const
+    {
+        return value >= other.value;
+    }
+
+private:
+    long value;
+};
+
+// only used to tell the units apart
+struct CountUnit {};
+struct SixteenthUnit {};
+struct LiftUnit {};
+
+// IME counts
+typedef Quantity<CountUnit> Counts;
+// 1/16 inches
+typedef Quantity<SixteenthUnit> Sixteenths;
+// lift/mgl position, see LIFT_UNIT_SHIFT
+typedef Quantity<LiftUnit> LiftUnits;
+
+template <typename Unit>
+constexpr Quantity<Unit> abs(Quantity<Unit> quantity)
+{
+    return quantity.get() < 0 ? -quantity : quantity;
+}
+
+// turns a ratio into a fixed point conversion factor, this should only ever
+//  be given constants so the floating point math happens at compile time
+constexpr long long factor(double ratio)
+{
+    return (long long) (ratio * (1ll << UNITS_SHIFT) +
+        (ratio < 0 ? -0.5 : 0.5));
+}
+
+// multiplies by a fixed point factor, rounding to the nearest whole number
+constexpr long scale(long long value, long long fixedFactor)
+{
+    return (long) ((value * fixedFactor + (1ll << (UNITS_SHIFT - 1))) >>
+        UNITS_SHIFT);
+}
+
+// converts an amount of one unit into another, FACTOR is how many of To
+//  there are in one From and should come from factor()
+template <typename To, long long FACTOR, typename From>
+constexpr To convert(Quantity<From> from)
+{
+    return To(scale(from.get(), FACTOR));
+}
+
+// how far a drive wheel goes in one IME count
+#define SIXTEENTHS_PER_COUNT (2 * M_PI * WHEEL_RADIUS / COUNTS_PER_REV_TORQUE)
+
+constexpr Sixteenths toSixteenths(Counts counts)
+{
+    return convert<Sixteenths, factor(SIXTEENTHS_PER_COUNT)>(counts);
+}
+
+constexpr Counts toCounts(Sixteenths distance)
+{
+    return convert<Counts, factor(1 / SIXTEENTHS_PER_COUNT)>(distance);
+}
+} // end namespace units
+
+#endif // UNITS_HPP
@@ -0,0 +1,695 @@
+// contains the simulator's version of everything in API.h
+// all of it just hands things off to the kernel, the world or the host, so
+//  this is the only place that has to know about API.h's types
+
+#include <API.h>
+#include <math.h>
+#include <string.h>
+
+#include "sim.hpp"
+
+// gyros need a multiplier of 196 to read in degrees, see gyroInit() in API.h
+#define GYRO_DEFAULT_MULTIPLIER 196
+// the backup battery is always full
+#define BACKUP_LEVEL 9000
+// longest string that any of the printf()s will print
+#define PRINT_SIZE 1024
+
+struct SimGyro
+{
+    double zero;
+    unsigned short multiplier;
+};
+
+struct RunLoop
+{
+    void (*fn)(void);
+    unsigned long increment;
+};
+
+// edges that each pin is waiting for and who to call when they happen
+static unsigned char interruptEdges[SIM_PIN_COUNT];
+static InterruptHandler interruptHandlers[SIM_PIN_COUNT];
+static bool lastPins[SIM_PIN_COUNT];
+
+static bool enabled = true;
+static bool autonomous = true;
+// every imeGet*() and imeReset() is its own I2C transaction on the cortex
+static unsigned long imeTransactions = 0;
+
+static PROS_FILE* toFile(int stream)
+{
+    return (PROS_FILE*) (intptr_t) stream;
+}
+
+static int fromFile(PROS_FILE* stream)
+{
+    return (int) (intptr_t) stream;
+}
+
+static bool isStream(PROS_FILE* stream)
+{
+    return stream == uart1 || stream == uart2 || stream == stdout;
+}
+
+// writes to a UART, the terminal or a file
+static size_t put(PROS_FILE* stream, const void* data, size_t size)
+{
+    if (isStream(stream))
+    {
+        sim::writeStream(fromFile(stream), (const char*) data, size);
+        return size;
+    }
+    return sim::writeFile(fromFile(stream), data, size);
+}
+
+static int putFormatted(PROS_FILE* stream, const char* formatString,
+    va_list args)
+{
+    char buffer[PRINT_SIZE];
+    int length = sim::format(buffer, sizeof(buffer), formatString, args);
+    if (length > (int) sizeof(buffer) - 1)
+    {
+        length = sizeof(buffer) - 1;
+    }
+    if (length > 0)
+    {
+        put(stream, buffer, length);
+    }
+    return length;
+}
+
+static void runLoop(void* param)
+{
+    RunLoop* loop = (RunLoop*) param;
+    unsigned long time = millis();
+    while (true)
+    {
+        loop->fn();
+        taskDelayUntil(&time, loop->increment);
+    }
+}
+
+// declared in sim.hpp
+
+void sim::checkInterrupts()
+{
+    for (unsigned char pin = 1; pin <= SIM_PIN_COUNT; ++pin)
+    {
+        bool value = readPin(pin);
+        bool last = lastPins[pin - 1];
+        lastPins[pin - 1] = value;
+        if (interruptHandlers[pin - 1] == NULL || value == last)
+        {
+            continue;
+        }
+        unsigned char edge = value ? INTERRUPT_EDGE_RISING :
+            INTERRUPT_EDGE_FALLING;
+        if (interruptEdges[pin - 1] & edge)
+        {
+            interruptHandlers[pin - 1](pin);
+        }
+    }
+}
+
+void sim::setCompetition(bool newEnabled, bool newAutonomous)
+{
+    enabled = newEnabled;
+    autonomous = newAutonomous;
+}
+
+unsigned long sim::getImeTransactions()
+{
+    return imeTransactions;
+}
+
+// declared in API.h
+
+bool isAutonomous()
+{
+    return autonomous;
+}
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+bool isJoystickConnected(unsigned char joystick)
+{
+    return false;
+}
+
+bool isOnline()
+{
+    return false;
+}
+
+int joystickGetAnalog(unsigned char joystick, unsigned char axis)
+{
+    return 0;
+}
+
+bool joystickGetDigital(unsigned char joystick, unsigned char buttonGroup,
+    unsigned char button)
+{
+    return false;
+}
+
+unsigned int powerLevelBackup()
+{
+    return BACKUP_LEVEL;
+}
+
+unsigned int powerLevelMain()
+{
+    return sim::getBatteryLevel();
+}
+
+void setTeamName(const char *name) {}
+
+int analogCalibrate(unsigned char channel)
+{
+    return 0;
+}
+
+int analogRead(unsigned char channel)
+{
+    return 0;
+}
+
+int analogReadCalibrated(unsigned char channel)
+{
+    return 0;
+}
+
+int analogReadCalibratedHR(unsigned char channel)
+{
+    return 0;
+}
+
+bool digitalRead(unsigned char pin)
+{
+    return sim::readPin(pin);
+}
+
+void digitalWrite(unsigned char pin, bool value)
+{
+    sim::writePin(pin, value);
+}
+
+void pinMode(unsigned char pin, unsigned char mode) {}
+
+void ioClearInterrupt(unsigned char pin)
+{
+    if (pin >= 1 && pin <= SIM_PIN_COUNT)
+    {
+        interruptHandlers[pin - 1] = NULL;
+    }
+}
+
+void ioSetInterrupt(unsigned char pin, unsigned char edges,
+    InterruptHandler handler)
+{
+    if (pin >= 1 && pin <= SIM_PIN_COUNT)
+    {
+        lastPins[pin - 1] = sim::readPin(pin);
+        interruptEdges[pin - 1] = edges;
+        interruptHandlers[pin - 1] = handler;
+    }
+}
+
+int motorGet(unsigned char channel)
+{
+    return sim::getMotor(channel);
+}
+
+void motorSet(unsigned char channel, int speed)
+{
+    sim::setMotor(channel, speed);
+}
+
+void motorStop(unsigned char channel)
+{
+    sim::setMotor(channel, 0);
+}
+
+void motorStopAll()
+{
+    for (unsigned char port = 1; port <= SIM_PORT_COUNT; ++port)
+    {
+        sim::setMotor(port, 0);
+    }
+}
+
+void speakerInit() {}
+
+void speakerPlayArray(const char * * songs) {}
+
+void speakerPlayRtttl(const char *song) {}
+
+void speakerShutdown() {}
+
+unsigned int imeInitializeAll()
+{
+    return sim::getImeCount();
+}
+
+bool imeGet(unsigned char address, int *value)
+{
+    ++imeTransactions;
+    return sim::readIme(address, value, NULL);
+}
+
+bool imeGetVelocity(unsigned char address, int *value)
+{
+    ++imeTransactions;
+    return sim::readIme(address, NULL, value);
+}
+
+bool imeReset(unsigned char address)
+{
+    ++imeTransactions;
+    return sim::resetIme(address);
+}
+
+void imeShutdown() {}
+
+int gyroGet(Gyro gyro)
+{
+    SimGyro* simGyro = (SimGyro*) gyro;
+    // rounded to the nearest degree like the real thing
+    return (int) floor((sim::getGyroHeading() - simGyro->zero) *
+        simGyro->multiplier / GYRO_DEFAULT_MULTIPLIER + 0.5);
+}
+
+Gyro gyroInit(unsigned char port, unsigned short multiplier)
+{
+    SimGyro* gyro = new SimGyro;
+    gyro->zero = sim::getGyroHeading();
+    gyro->multiplier = multiplier == 0 ? GYRO_DEFAULT_MULTIPLIER : multiplier;
+    return gyro;
+}
+
+void gyroReset(Gyro gyro)
+{
+    ((SimGyro*) gyro)->zero = sim::getGyroHeading();
+}
+
+void gyroShutdown(Gyro gyro) {}
+
+int encoderGet(Encoder enc)
+{
+    return 0;
+}
+
+Encoder encoderInit(unsigned char portTop, unsigned char portBottom,
+    bool reverse)
+{
+    return NULL;
+}
+
+void encoderReset(Encoder enc) {}
+
+void encoderShutdown(Encoder enc) {}
+
+int ultrasonicGet(Ultrasonic ult)
+{
+    return ULTRA_BAD_RESPONSE;
+}
+
+Ultrasonic ultrasonicInit(unsigned char portEcho, unsigned char portPing)
+{
+    return NULL;
+}
+
+void ultrasonicShutdown(Ultrasonic ult) {}
+
+bool i2cRead(uint8_t addr, uint8_t *data, uint16_t count)
+{
+    return false;
+}
+
+bool i2cReadRegister(uint8_t addr, uint8_t reg, uint8_t *value, uint16_t count)
+{
+    return false;
+}
+
+bool i2cWrite(uint8_t addr, uint8_t *data, uint16_t count)
+{
+    return false;
+}
+
+bool i2cWriteRegister(uint8_t addr, uint8_t reg, uint16_t value)
+{
+    return false;
+}
+
+void usartInit(PROS_FILE *usart, unsigned int baud, unsigned int flags) {}
+
+void usartShutdown(PROS_FILE *usart) {}
+
+void fclose(PROS_FILE *stream)
+{
+    if (!isStream(stream))
+    {
+        sim::closeFile(fromFile(stream));
+    }
+}
+
+int fcount(PROS_FILE *stream)
+{
+    return isStream(stream) ? 0 : sim::countFile(fromFile(stream));
+}
+
+int fdelete(const char *file)
+{
+    return sim::deleteFile(file);
+}
+
+int feof(PROS_FILE *stream)
+{
+    return isStream(stream) ? 0 : sim::isFileEnd(fromFile(stream));
+}
+
+int fflush(PROS_FILE *stream)
+{
+    return 0;
+}
+
+int fgetc(PROS_FILE *stream)
+{
+    unsigned char value;
+    if (isStream(stream) || sim::readFile(fromFile(stream), &value, 1) != 1)
+    {
+        return EOF;
+    }
+    return value;
+}
+
+char* fgets(char *str, int num, PROS_FILE *stream)
+{
+    int length = 0;
+    while (length < num - 1)
+    {
+        int value = fgetc(stream);
+        if (value == EOF)
+        {
+            break;
+        }
+        str[length++] = (char) value;
+        if (value == '\n')
+        {
+            break;
+        }
+    }
+    if (length == 0)
+    {
+        return NULL;
+    }
+    str[length] = '\0';
+    return str;
+}
+
+PROS_FILE * fopen(const char *file, const char *mode)
+{
+    int handle = sim::openFile(file, mode);
+    return handle == 0 ? NULL : toFile(handle);
+}
+
+void fprint(const char *string, PROS_FILE *stream)
+{
+    put(stream, string, strlen(string));
+}
+
+int fputc(int value, PROS_FILE *stream)
+{
+    unsigned char byte = (unsigned char) value;
+    return put(stream, &byte, 1) == 1 ? byte : EOF;
+}
+
+int fputs(const char *string, PROS_FILE *stream)
+{
+    size_t length = strlen(string);
+    return put(stream, string, length) == length ? (int) length : EOF;
+}
+
+size_t fread(void *ptr, size_t size, size_t count, PROS_FILE *stream)
+{
+    if (isStream(stream) || size == 0)
+    {
+        return 0;
+    }
+    return sim::readFile(fromFile(stream), ptr, size * count) / size;
+}
+
+int fseek(PROS_FILE *stream, long int offset, int origin)
+{
+    return isStream(stream) ? -1 :
+        sim::seekFile(fromFile(stream), offset, origin);
+}
+
+long int ftell(PROS_FILE *stream)
+{
+    return isStream(stream) ? -1 : sim::tellFile(fromFile(stream));
+}
+
+size_t fwrite(const void *ptr, size_t size, size_t count, PROS_FILE *stream)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    return put(stream, ptr, size * count) / size;
+}
+
+int getchar()
+{
+    return EOF;
+}
+
+void print(const char *string)
+{
+    fprint(string, stdout);
+}
+
+int putchar(int value)
+{
+    return fputc(value, stdout);
+}
+
+int puts(const char *string)
+{
+    fprint(string, stdout);
+    fputc('\n', stdout);
+    return 1;
+}
+
+int fprintf(PROS_FILE *stream, const char *formatString, ...)
+{
+    va_list args;
+    va_start(args, formatString);
+    int length = putFormatted(stream, formatString, args);
+    va_end(args);
+    return length;
+}
+
+int printf(const char *formatString, ...)
+{
+    va_list args;
+    va_start(args, formatString);
+    int length = putFormatted(stdout, formatString, args);
+    va_end(args);
+    return length;
+}
+
+int snprintf(char *buffer, size_t limit, const char *formatString, ...)
+{
+    va_list args;
+    va_start(args, formatString);
+    int length = sim::format(buffer, limit, formatString, args);
+    va_end(args);
+    return length;
+}
+
+int sprintf(char *buffer, const char *formatString, ...)
+{
+    va_list args;
+    va_start(args, formatString);
+    int length = sim::format(buffer, PRINT_SIZE, formatString, args);
+    va_end(args);
+    return length;
+}
+
+void lcdClear(PROS_FILE *lcdPort)
+{
+    sim::setLcdLine(1, "");
+    sim::setLcdLine(2, "");
+}
+
+void lcdInit(PROS_FILE *lcdPort) {}
+
+void lcdPrint(PROS_FILE *lcdPort, unsigned char line,
+    const char *formatString, ...)
+{
+    char buffer[PRINT_SIZE];
+    va_list args;
+    va_start(args, formatString);
+    sim::format(buffer, sizeof(buffer), formatString, args);
+    va_end(args);
+    sim::setLcdLine(line, buffer);
+}
+
+unsigned int lcdReadButtons(PROS_FILE *lcdPort)
+{
+    return 0;
+}
+
+void lcdSetBacklight(PROS_FILE *lcdPort, bool backlight) {}
+
+void lcdSetText(PROS_FILE *lcdPort, unsigned char line, const char *buffer)
+{
+    sim::setLcdLine(line, buffer);
+}
+
+void lcdShutdown(PROS_FILE *lcdPort) {}
+
+TaskHandle taskCreate(TaskCode taskCode, const unsigned int stackDepth,
+    void *parameters, const unsigned int priority)
+{
+    return sim::createTask(taskCode, parameters, priority);
+}
+
+void taskDelay(const unsigned long msToDelay)
+{
+    sim::sleepUntil(sim::getTime() + msToDelay * 1000);
+}
+
+void taskDelayUntil(unsigned long *previousWakeTime,
+    const unsigned long cycleTime)
+{
+    *previousWakeTime += cycleTime;
+    // like FreeRTOS, don't wait at all if the wake time already went by
+    if (*previousWakeTime * 1000 > sim::getTime())
+    {
+        sim::sleepUntil(*previousWakeTime * 1000);
+    }
+}
+
+void taskDelete(TaskHandle taskToDelete)
+{
+    sim::deleteTask(taskToDelete);
+}
+
+unsigned int taskGetCount()
+{
+    return sim::getTaskCount();
+}
+
+unsigned int taskGetState(TaskHandle task)
+{
+    return sim::getState(task);
+}
+
+unsigned int taskPriorityGet(const TaskHandle task)
+{
+    return sim::getPriority(task);
+}
+
+void taskPrioritySet(TaskHandle task, const unsigned int newPriority)
+{
+    sim::setPriority(task, newPriority);
+}
+
+void taskResume(TaskHandle taskToResume)
+{
+    sim::resumeTask(taskToResume);
+}
+
+TaskHandle taskRunLoop(void (*fn)(void), const unsigned long increment)
+{
+    RunLoop* loop = new RunLoop;
+    loop->fn = fn;
+    loop->increment = increment;
+    return sim::createTask(runLoop, loop, TASK_PRIORITY_DEFAULT + 1);
+}
+
+void taskSuspend(TaskHandle taskToSuspend)
+{
+    sim::suspendTask(taskToSuspend);
+}
+
+Semaphore semaphoreCreate()
+{
+    return sim::createLock(false);
+}
+
+bool semaphoreGive(Semaphore semaphore)
+{
+    return sim::give(semaphore);
+}
+
+bool semaphoreTake(Semaphore semaphore, const unsigned long blockTime)
+{
+    return sim::take(semaphore, blockTime);
+}
+
+void semaphoreDelete(Semaphore semaphore)
+{
+    sim::deleteLock(semaphore);
+}
+
+Mutex mutexCreate()
+{
+    return sim::createLock(true);
+}
+
+bool mutexGive(Mutex mutex)
+{
+    return sim::give(mutex);
+}
+
+bool mutexTake(Mutex mutex, const unsigned long blockTime)
+{
+    return sim::take(mutex, blockTime);
+}
+
+void mutexDelete(Mutex mutex)
+{
+    sim::deleteLock(mutex);
+}
+
+void delay(const unsigned long time)
+{
+    taskDelay(time);
+}
+
+void delayMicroseconds(const unsigned long us)
+{
+    // the cortex busy waits, but virtual time only moves when tasks block
+    sim::sleepUntil(sim::getTime() + us);
+}
+
+unsigned long micros()
+{
+    return sim::getTime();
+}
+
+unsigned long millis()
+{
+    return sim::getTime() / 1000;
+}
+
+void wait(const unsigned long time)
+{
+    taskDelay(time);
+}
+
+void waitUntil(unsigned long *previousWakeTime, const unsigned long time)
+{
+    taskDelayUntil(previousWakeTime, time);
+}
+
+void watchdogInit() {}
+
+void standaloneModeEnable() {}
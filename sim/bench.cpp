@@ -0,0 +1,398 @@
+// times the math the lift controller and the drive follower do every tick,
+//  the way it used to be done in doubles and the way it's done now in the
+//  fixed point from units.hpp and profile::Profile
+//
+// usage: bench [options]
+//  -n <calls>  how many times each one gets called (default 1000000)
+//
+// both versions are copies of the math in controlLift() and DriveAction's
+//  step() without the sensor reads around them, except for the fixed point
+//  profile, which is the real one out of src/profile.cpp
+// it counts instructions with the host's performance counters when there are
+//  any, and cycles with the time stamp counter (or ns if there isn't one)
+// the host does doubles in hardware, so the two come out about even here, the
+//  difference only shows up on the cortex, where every double add, multiply
+//  and conversion is a call into the soft float library
+
+#include "main.hpp"
+
+#include <linux/perf_event.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// amount of different inputs each version goes through
+#define INPUT_COUNT 1024
+// the profile that gets followed, in 1/16 inches (per second^n)
+#define BENCH_DISTANCE 740.0
+#define BENCH_VELOCITY 300.0
+#define BENCH_ACCEL 600.0
+#define BENCH_JERK 3000.0
+
+// the lift's constants, as motors.cpp has them
+#define LIFT_MAX_REVS 4.4
+#define RPM_DIVISOR_TORQUE 39.2
+#define LIFT_UNITS_PER_COUNT (127.0 * (1 << LIFT_UNIT_SHIFT) / \
+    (LIFT_MAX_REVS * COUNTS_PER_REV_TORQUE))
+#define LIFT_ONE (1l << LIFT_UNIT_SHIFT)
+
+// what one tick of either version gets
+struct Input
+{
+    int liftCounts;
+    int liftVelocity;
+    // in position units
+    double liftTarget;
+    int leftCounts;
+    int rightCounts;
+    // 1/16 inches per second
+    long leftSpeed;
+    long rightSpeed;
+    // ms since the profile started
+    unsigned long elapsed;
+};
+
+static Input inputs[INPUT_COUNT];
+// everything gets added into this so none of it can be optimized out
+static volatile long sink;
+
+// the S-curve profile the way profile.cpp used to keep it, in doubles
+class DoubleProfile
+{
+public:
+    void plan(double distance, const profile::Limits& limits)
+    {
+        direction = distance < 0 ? -1 : 1;
+        distance = fabs(distance);
+        double peak = limits.velocity;
+        double jerkTime;
+        double rampTime = accelTime(peak, limits, &jerkTime);
+        if (peak * rampTime > distance)
+        {
+            double low = 0;
+            double high = peak;
+            for (int i = 0; i < 24; ++i)
+            {
+                peak = (low + high) / 2;
+                if (peak * accelTime(peak, limits, &jerkTime) > distance)
+                {
+                    high = peak;
+                }
+                else
+                {
+                    low = peak;
+                }
+            }
+            peak = low;
+            rampTime = accelTime(peak, limits, &jerkTime);
+        }
+        double cruiseTime = peak > 0 ? (distance - peak * rampTime) / peak : 0;
+        double constTime = rampTime - 2 * jerkTime;
+        double maxAccel = limits.jerk * jerkTime;
+        const double lengths[SEGMENT_COUNT] =
+        {
+            jerkTime, constTime, jerkTime, cruiseTime, jerkTime, constTime,
+            jerkTime
+        };
+        const double accels[SEGMENT_COUNT] =
+        {
+            0, maxAccel, maxAccel, 0, 0, -maxAccel, -maxAccel
+        };
+        const double jerks[SEGMENT_COUNT] =
+        {
+            limits.jerk, 0, -limits.jerk, 0, -limits.jerk, 0, limits.jerk
+        };
+        double t = 0;
+        double pos = 0;
+        double vel = 0;
+        for (int i = 0; i < SEGMENT_COUNT; ++i)
+        {
+            Segment& segment = segments[i];
+            segment.start = t;
+            segment.position = pos;
+            segment.velocity = vel;
+            segment.acceleration = accels[i];
+            segment.jerk = jerks[i];
+            double dt = lengths[i];
+            pos += vel * dt + accels[i] * dt * dt / 2 +
+                jerks[i] * dt * dt * dt / 6;
+            vel += accels[i] * dt + jerks[i] * dt * dt / 2;
+            t += dt;
+        }
+        duration = t;
+    }
+
+    void at(unsigned long time, double& position, double& velocity,
+        double& acceleration) const
+    {
+        double t = time / 1000.0;
+        if (t > duration)
+        {
+            t = duration;
+        }
+        int i = SEGMENT_COUNT - 1;
+        while (i > 0 && segments[i].start > t)
+        {
+            --i;
+        }
+        const Segment& segment = segments[i];
+        double dt = t - segment.start;
+        position = direction * (segment.position + segment.velocity * dt +
+            segment.acceleration * dt * dt / 2 +
+            segment.jerk * dt * dt * dt / 6);
+        velocity = direction * (segment.velocity +
+            segment.acceleration * dt + segment.jerk * dt * dt / 2);
+        acceleration = direction * (segment.acceleration + segment.jerk * dt);
+        if (time / 1000.0 >= duration)
+        {
+            velocity = 0;
+            acceleration = 0;
+        }
+    }
+
+    unsigned long getDuration() const
+    {
+        return (unsigned long) (duration * 1000 + 0.5);
+    }
+
+private:
+    static double accelTime(double velocity, const profile::Limits& limits,
+        double* jerkTime)
+    {
+        if (velocity * limits.jerk >= limits.acceleration * limits.acceleration)
+        {
+            *jerkTime = limits.acceleration / limits.jerk;
+            return velocity / limits.acceleration + *jerkTime;
+        }
+        *jerkTime = sqrt(velocity / limits.jerk);
+        return 2 * *jerkTime;
+    }
+
+    enum { SEGMENT_COUNT = 7 };
+    struct Segment
+    {
+        double start;
+        double position;
+        double velocity;
+        double acceleration;
+        double jerk;
+    };
+    Segment segments[SEGMENT_COUNT];
+    double direction;
+    double duration;
+};
+
+static DoubleProfile doubleProfile;
+static profile::Profile fixedProfile;
+
+static int clamp(long power)
+{
+    return power > 127 ? 127 : power < -127 ? -127 : (int) power;
+}
+
+// controlLift() when it was in doubles
+static __attribute__((noinline)) int liftDouble(const Input& input)
+{
+    static double integral = 0;
+    double pos = 127.0 / (LIFT_MAX_REVS * COUNTS_PER_REV_TORQUE) *
+        -input.liftCounts;
+    double velocity = 127.0 / LIFT_MAX_REVS / 60 *
+        -(input.liftVelocity / RPM_DIVISOR_TORQUE);
+    double error = input.liftTarget - pos;
+    if (fabs(error) > 4.0 || (error > 0 && integral < 0) ||
+        (error < 0 && integral > 0))
+    {
+        integral = 0;
+    }
+    double drive = 15.0 + 20.0 * error + integral - 0.3 * velocity;
+    if (fabs(error) <= 4.0 && (drive < 127 || error < 0) &&
+        (drive > -127 || error > 0))
+    {
+        integral += 4.0 * error * MOTOR_POLL_RATE / 1000;
+        integral = integral > 40.0 ? 40.0 : integral < -40.0 ? -40.0 :
+            integral;
+    }
+    drive = drive > 127 ? 127 : drive < -127 ? -127 : drive;
+    return (int) drive;
+}
+
+// controlLift() now
+static __attribute__((noinline)) int liftFixed(const Input& input)
+{
+    static long integral = 0;
+    static const long long speedFactor = units::factor(LIFT_UNITS_PER_COUNT *
+        COUNTS_PER_REV_TORQUE / (60 * RPM_DIVISOR_TORQUE));
+    units::LiftUnits pos = units::convert<units::LiftUnits,
+        units::factor(LIFT_UNITS_PER_COUNT)>(units::Counts(
+        -input.liftCounts));
+    long speed = -units::scale(input.liftVelocity, speedFactor);
+    // the target is already fixed point on the robot
+    units::LiftUnits target((long) input.liftTarget << LIFT_UNIT_SHIFT);
+    units::LiftUnits error = target - pos;
+    bool near = units::abs(error) <= units::LiftUnits(4 * LIFT_ONE);
+    if (!near || (error.get() > 0 && integral < 0) ||
+        (error.get() < 0 && integral > 0))
+    {
+        integral = 0;
+    }
+    long drive = 15 * LIFT_ONE + error.get() * 20 + integral -
+        speed * 3 / 10;
+    if (near && (drive < 127 * LIFT_ONE || error.get() < 0) &&
+        (drive > -127 * LIFT_ONE || error.get() > 0))
+    {
+        integral += error.get() * 4 * MOTOR_POLL_RATE / 1000;
+        integral = integral > 40 * LIFT_ONE ? 40 * LIFT_ONE :
+            integral < -40 * LIFT_ONE ? -40 * LIFT_ONE : integral;
+    }
+    drive = drive > 127 * LIFT_ONE ? 127 * LIFT_ONE :
+        drive < -127 * LIFT_ONE ? -127 * LIFT_ONE : drive;
+    return (int) (drive / LIFT_ONE);
+}
+
+// DriveAction's step() when it was in doubles, without the heading hold
+static __attribute__((noinline)) int driveDouble(const Input& input)
+{
+    const double circumference = 2.0 * WHEEL_RADIUS * M_PI;
+    double position;
+    double velocity;
+    double acceleration;
+    doubleProfile.at(input.elapsed, position, velocity, acceleration);
+    double gone = circumference * (input.leftCounts + input.rightCounts) /
+        (2 * COUNTS_PER_REV_TORQUE);
+    double speed = (input.leftSpeed + input.rightSpeed) / 2.0;
+    double forward = 127.0 / 335.0 * velocity + 0.02 * acceleration +
+        1.0 * (position - gone) + 0.1 * (velocity - speed);
+    forward = forward > 127 ? 127 : forward < -127 ? -127 : forward;
+    return (int) forward;
+}
+
+// DriveAction's step() now, without the heading hold
+static __attribute__((noinline)) int driveFixed(const Input& input)
+{
+    profile::Setpoint setpoint = fixedProfile.at(input.elapsed);
+    long gone = units::toSixteenths(units::Counts(input.leftCounts +
+        input.rightCounts)).get() / 2;
+    long speed = (input.leftSpeed + input.rightSpeed) / 2;
+    return clamp(setpoint.velocity * 127 / 335 +
+        setpoint.acceleration * 1 / 50 + (setpoint.position - gone) * 1 +
+        (setpoint.velocity - speed) * 1 / 10);
+}
+
+// counts this process's instructions, or returns -1 if it can't
+static int openCounter()
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static unsigned long long readCounter(int counter)
+{
+    unsigned long long count = 0;
+    if (counter < 0 || read(counter, &count, sizeof(count)) != sizeof(count))
+    {
+        return 0;
+    }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CLOCK_UNIT "cycles"
+static unsigned long long readClock()
+{
+    return __rdtsc();
+}
+#else
+#define CLOCK_UNIT "ns"
+static unsigned long long readClock()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+#endif
+
+// runs one version calls times and prints what each call cost
+static void run(const char* name, int (*version)(const Input&),
+    unsigned long calls, int counter)
+{
+    long total = 0;
+    unsigned long long instructions = readCounter(counter);
+    unsigned long long clock = readClock();
+    for (unsigned long i = 0; i < calls; ++i)
+    {
+        total += version(inputs[i % INPUT_COUNT]);
+    }
+    clock = readClock() - clock;
+    instructions = readCounter(counter) - instructions;
+    sink = total;
+    printf("%-13s %8.1f %s", name, (double) clock / calls, CLOCK_UNIT);
+    if (counter >= 0)
+    {
+        printf(" %8.1f instructions", (double) instructions / calls);
+    }
+    printf(" per call\n");
+}
+
+static void usage()
+{
+    printf("usage: bench [-n calls]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long calls = 1000000;
+    int option;
+    while ((option = getopt(argc, argv, "n:")) != -1)
+    {
+        switch (option)
+        {
+        case 'n':
+            calls = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (calls == 0)
+    {
+        usage();
+    }
+    profile::Limits limits = { BENCH_VELOCITY, BENCH_ACCEL, BENCH_JERK };
+    doubleProfile.plan(BENCH_DISTANCE, limits);
+    fixedProfile.plan(BENCH_DISTANCE, limits);
+    srand(1);
+    for (unsigned int i = 0; i < INPUT_COUNT; ++i)
+    {
+        Input& input = inputs[i];
+        input.liftCounts = -(rand() % 2800);
+        input.liftVelocity = rand() % 4000 - 2000;
+        input.liftTarget = rand() % 128;
+        input.elapsed = rand() % (doubleProfile.getDuration() + 500);
+        input.leftCounts = rand() % 3600;
+        input.rightCounts = input.leftCounts + rand() % 20 - 10;
+        input.leftSpeed = rand() % 320;
+        input.rightSpeed = input.leftSpeed + rand() % 10 - 5;
+    }
+    int counter = openCounter();
+    if (counter < 0)
+    {
+        printf("no performance counters, so only " CLOCK_UNIT "\n");
+    }
+    run("lift double", liftDouble, calls, counter);
+    run("lift fixed", liftFixed, calls, counter);
+    run("drive double", driveDouble, calls, counter);
+    run("drive fixed", driveFixed, calls, counter);
+    return 0;
+}
@@ -0,0 +1,347 @@
+// contains the host side of the simulated cortex's terminal, UARTs, LCD and
+//  flash file system
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.hpp"
+
+// the cortex's file names are at most 8 characters
+#define FILE_NAME_SIZE 9
+#define MAX_FILES 32
+#define FILE_SIZE (64 * 1024)
+#define MAX_OPEN_FILES 4
+// file handles start after the UARTs and the terminal
+#define FIRST_FILE 4
+#define LCD_WIDTH 16
+// bytes sent over the UART for each line set on the LCD
+#define LCD_PACKET_SIZE 22
+
+struct File
+{
+    char name[FILE_NAME_SIZE];
+    unsigned char data[FILE_SIZE];
+    size_t size;
+};
+
+struct OpenFile
+{
+    File* file;
+    size_t position;
+    bool writing;
+};
+
+static File files[MAX_FILES];
+static OpenFile openFiles[MAX_OPEN_FILES];
+static bool quiet = false;
+static bool showLcd = false;
+static unsigned long uartBytes = 0;
+// where uart2 goes, if anywhere
+static FILE* uart2Output = NULL;
+static char lcdLines[2][LCD_WIDTH + 1];
+static unsigned long lcdBytes = 0;
+
+static File* findFile(const char* name)
+{
+    for (unsigned int i = 0; i < MAX_FILES; ++i)
+    {
+        if (files[i].name[0] != '\0' &&
+            strncmp(files[i].name, name, FILE_NAME_SIZE - 1) == 0)
+        {
+            return &files[i];
+        }
+    }
+    return NULL;
+}
+
+static File* createFile(const char* name)
+{
+    for (unsigned int i = 0; i < MAX_FILES; ++i)
+    {
+        if (files[i].name[0] == '\0')
+        {
+            snprintf(files[i].name, FILE_NAME_SIZE, "%.8s", name);
+            files[i].size = 0;
+            return &files[i];
+        }
+    }
+    return NULL;
+}
+
+static OpenFile* getOpenFile(int file)
+{
+    if (file < FIRST_FILE || file >= FIRST_FILE + MAX_OPEN_FILES ||
+        openFiles[file - FIRST_FILE].file == NULL)
+    {
+        return NULL;
+    }
+    return &openFiles[file - FIRST_FILE];
+}
+
+// declared in sim.hpp
+
+int sim::format(char* buffer, size_t size, const char* fmt, va_list args)
+{
+    return vsnprintf(buffer, size, fmt, args);
+}
+
+void sim::setQuiet(bool newQuiet)
+{
+    quiet = newQuiet;
+}
+
+void sim::setShowLcd(bool show)
+{
+    showLcd = show;
+}
+
+void sim::writeStream(int stream, const char* data, size_t size)
+{
+    if (stream == 3)
+    {
+        if (!quiet)
+        {
+            fwrite(data, 1, size, stdout);
+        }
+        return;
+    }
+    uartBytes += size;
+    if (stream == 2 && uart2Output != NULL)
+    {
+        fwrite(data, 1, size, uart2Output);
+        fflush(uart2Output);
+    }
+}
+
+bool sim::setUart2Output(const char* path)
+{
+    uart2Output = fopen(path, "wb");
+    return uart2Output != NULL;
+}
+
+unsigned long sim::getUartBytes()
+{
+    return uartBytes;
+}
+
+void sim::setLcdLine(unsigned char line, const char* text)
+{
+    if (line < 1 || line > 2)
+    {
+        return;
+    }
+    lcdBytes += LCD_PACKET_SIZE;
+    char* current = lcdLines[line - 1];
+    if (strncmp(current, text, LCD_WIDTH) == 0)
+    {
+        return;
+    }
+    strncpy(current, text, LCD_WIDTH);
+    current[LCD_WIDTH] = '\0';
+    if (showLcd)
+    {
+        printf("[%8.3f] lcd |%-16s|%-16s|\n", getTime() / 1000000.0,
+            lcdLines[0], lcdLines[1]);
+    }
+}
+
+const char* sim::getLcdLine(unsigned char line)
+{
+    return line >= 1 && line <= 2 ? lcdLines[line - 1] : "";
+}
+
+unsigned long sim::getLcdBytes()
+{
+    return lcdBytes;
+}
+
+bool sim::loadFiles(const char* directory)
+{
+    DIR* dir = opendir(directory);
+    if (dir == NULL)
+    {
+        return false;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] == '.' ||
+            strlen(entry->d_name) >= FILE_NAME_SIZE)
+        {
+            continue;
+        }
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        FILE* host = fopen(path, "rb");
+        if (host == NULL)
+        {
+            continue;
+        }
+        File* file = findFile(entry->d_name);
+        if (file == NULL)
+        {
+            file = createFile(entry->d_name);
+        }
+        if (file != NULL)
+        {
+            file->size = fread(file->data, 1, FILE_SIZE, host);
+        }
+        fclose(host);
+    }
+    closedir(dir);
+    return true;
+}
+
+bool sim::saveFiles(const char* directory)
+{
+    for (unsigned int i = 0; i < MAX_FILES; ++i)
+    {
+        if (files[i].name[0] == '\0')
+        {
+            continue;
+        }
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%.8s", directory,
+            files[i].name);
+        FILE* host = fopen(path, "wb");
+        if (host == NULL)
+        {
+            return false;
+        }
+        fwrite(files[i].data, 1, files[i].size, host);
+        fclose(host);
+    }
+    return true;
+}
+
+int sim::openFile(const char* name, const char* mode)
+{
+    int handle = -1;
+    for (unsigned int i = 0; i < MAX_OPEN_FILES && handle < 0; ++i)
+    {
+        if (openFiles[i].file == NULL)
+        {
+            handle = i;
+        }
+    }
+    if (handle < 0)
+    {
+        return 0;
+    }
+    File* file = findFile(name);
+    bool writing = mode[0] == 'w' || mode[0] == 'a';
+    if (writing)
+    {
+        if (file == NULL)
+        {
+            file = createFile(name);
+        }
+        if (file != NULL && mode[0] == 'w')
+        {
+            file->size = 0;
+        }
+    }
+    if (file == NULL)
+    {
+        return 0;
+    }
+    OpenFile& open = openFiles[handle];
+    open.file = file;
+    open.position = mode[0] == 'a' ? file->size : 0;
+    open.writing = writing;
+    return FIRST_FILE + handle;
+}
+
+void sim::closeFile(int file)
+{
+    OpenFile* open = getOpenFile(file);
+    if (open != NULL)
+    {
+        open->file = NULL;
+    }
+}
+
+size_t sim::readFile(int file, void* data, size_t size)
+{
+    OpenFile* open = getOpenFile(file);
+    if (open == NULL || open->writing)
+    {
+        return 0;
+    }
+    size_t left = open->file->size - open->position;
+    if (size > left)
+    {
+        size = left;
+    }
+    memcpy(data, open->file->data + open->position, size);
+    open->position += size;
+    return size;
+}
+
+size_t sim::writeFile(int file, const void* data, size_t size)
+{
+    OpenFile* open = getOpenFile(file);
+    if (open == NULL || !open->writing)
+    {
+        return 0;
+    }
+    size_t left = FILE_SIZE - open->position;
+    if (size > left)
+    {
+        size = left;
+    }
+    memcpy(open->file->data + open->position, data, size);
+    open->position += size;
+    if (open->position > open->file->size)
+    {
+        open->file->size = open->position;
+    }
+    return size;
+}
+
+int sim::seekFile(int file, long offset, int origin)
+{
+    OpenFile* open = getOpenFile(file);
+    if (open == NULL)
+    {
+        return -1;
+    }
+    long base = origin == SEEK_CUR ? (long) open->position :
+        origin == SEEK_END ? (long) open->file->size : 0;
+    if (base + offset < 0 || base + offset > (long) open->file->size)
+    {
+        return -1;
+    }
+    open->position = base + offset;
+    return 0;
+}
+
+long sim::tellFile(int file)
+{
+    OpenFile* open = getOpenFile(file);
+    return open == NULL ? -1 : (long) open->position;
+}
+
+bool sim::isFileEnd(int file)
+{
+    OpenFile* open = getOpenFile(file);
+    return open == NULL || open->position >= open->file->size;
+}
+
+int sim::countFile(int file)
+{
+    OpenFile* open = getOpenFile(file);
+    return open == NULL ? 0 : (int) (open->file->size - open->position);
+}
+
+int sim::deleteFile(const char* name)
+{
+    File* file = findFile(name);
+    if (file == NULL)
+    {
+        return -1;
+    }
+    file->name[0] = '\0';
+    return 0;
+}
@@ -0,0 +1,392 @@
+// contains the simulator's stand-in for FreeRTOS
+// every task is a ucontext coroutine and only one of them runs at a time,
+//  so the robot code never has to worry about real threads
+// virtual time only moves forward when every task is blocked, which is
+//  what lets a 15 second autonomous finish in a few milliseconds
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+#include "sim.hpp"
+
+// these match the TASK_* defines in API.h
+#define TASK_DEAD 0
+#define TASK_RUNNING 1
+#define TASK_RUNNABLE 2
+#define TASK_SLEEPING 3
+#define TASK_SUSPENDED 4
+
+#define MAX_TASKS 16
+// the host needs a lot more stack than the cortex, printf alone uses a few kb
+#define STACK_SIZE (128 * 1024)
+
+struct Lock
+{
+    bool mutex;
+    bool available;
+};
+
+struct Task
+{
+    ucontext_t context;
+    char* stack;
+    sim::TaskCode code;
+    void* param;
+    unsigned int priority;
+    unsigned int state;
+    // whether it should go back to the state it was in when it's resumed
+    bool suspended;
+    // when a sleeping or blocked task should be woken up
+    unsigned long wake;
+    // what a blocked task is waiting on
+    Lock* lock;
+    // whether the last take() got the lock before timing out
+    bool acquired;
+    // tasks that became ready earlier get to run first
+    unsigned long order;
+};
+
+static Task tasks[MAX_TASKS];
+static Task* current = NULL;
+static ucontext_t scheduler;
+static unsigned long now = 0;
+static unsigned long orders = 0;
+static unsigned long switches = 0;
+
+// entry point of every task, since makecontext() can't pass pointers
+static void start()
+{
+    current->code(current->param);
+    sim::deleteTask(NULL);
+}
+
+// gives control back to the scheduler until this task is picked again
+static void block()
+{
+    if (current == NULL)
+    {
+        fprintf(stderr, "sim: tried to block outside of a task\n");
+        abort();
+    }
+    swapcontext(&current->context, &scheduler);
+}
+
+// puts a task at the back of the ready list for its priority
+static void makeReady(Task* task)
+{
+    task->state = TASK_RUNNABLE;
+    task->order = orders++;
+}
+
+// the highest priority task that's ready to run, or the one of them that's
+//  been waiting the longest
+static Task* pickReady()
+{
+    Task* best = NULL;
+    for (unsigned int i = 0; i < MAX_TASKS; ++i)
+    {
+        Task* task = &tasks[i];
+        if (task->code == NULL || task->state != TASK_RUNNABLE ||
+            task->suspended)
+        {
+            continue;
+        }
+        if (best == NULL || task->priority > best->priority ||
+            (task->priority == best->priority && task->order < best->order))
+        {
+            best = task;
+        }
+    }
+    return best;
+}
+
+// the blocked task that should get a lock next
+static Task* pickWaiter(Lock* lock)
+{
+    Task* best = NULL;
+    for (unsigned int i = 0; i < MAX_TASKS; ++i)
+    {
+        Task* task = &tasks[i];
+        if (task->code == NULL || task->state != TASK_SLEEPING ||
+            task->lock != lock)
+        {
+            continue;
+        }
+        if (best == NULL || task->priority > best->priority ||
+            (task->priority == best->priority && task->order < best->order))
+        {
+            best = task;
+        }
+    }
+    return best;
+}
+
+// lets a higher priority task that just became ready run right away, like
+//  FreeRTOS would preempt the current one
+static void preempt(const Task* woken)
+{
+    if (current != NULL && woken->priority > current->priority)
+    {
+        makeReady(current);
+        block();
+    }
+}
+
+// frees the stacks of tasks that are done
+static void reap()
+{
+    for (unsigned int i = 0; i < MAX_TASKS; ++i)
+    {
+        Task* task = &tasks[i];
+        if (task->code != NULL && task->state == TASK_DEAD && task != current)
+        {
+            free(task->stack);
+            task->stack = NULL;
+            task->code = NULL;
+        }
+    }
+}
+
+// declared in sim.hpp
+
+void* sim::createTask(TaskCode code, void* param, unsigned int priority)
+{
+    Task* task = NULL;
+    for (unsigned int i = 0; i < MAX_TASKS && task == NULL; ++i)
+    {
+        if (tasks[i].code == NULL)
+        {
+            task = &tasks[i];
+        }
+    }
+    if (task == NULL)
+    {
+        return NULL;
+    }
+    task->stack = (char*) malloc(STACK_SIZE);
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = STACK_SIZE;
+    task->context.uc_link = &scheduler;
+    makecontext(&task->context, start, 0);
+    task->code = code;
+    task->param = param;
+    task->priority = priority;
+    task->suspended = false;
+    task->lock = NULL;
+    makeReady(task);
+    preempt(task);
+    return task;
+}
+
+void sim::deleteTask(void* handle)
+{
+    Task* task = handle == NULL ? current : (Task*) handle;
+    if (task == NULL)
+    {
+        return;
+    }
+    task->state = TASK_DEAD;
+    if (task == current)
+    {
+        // never comes back
+        block();
+    }
+}
+
+void sim::suspendTask(void* handle)
+{
+    Task* task = handle == NULL ? current : (Task*) handle;
+    task->suspended = true;
+    if (task == current)
+    {
+        makeReady(task);
+        block();
+    }
+}
+
+void sim::resumeTask(void* handle)
+{
+    Task* task = (Task*) handle;
+    task->suspended = false;
+    preempt(task);
+}
+
+void* sim::getCurrentTask()
+{
+    return current;
+}
+
+unsigned int sim::getPriority(void* handle)
+{
+    Task* task = handle == NULL ? current : (Task*) handle;
+    return task->priority;
+}
+
+void sim::setPriority(void* handle, unsigned int priority)
+{
+    Task* task = handle == NULL ? current : (Task*) handle;
+    task->priority = priority;
+}
+
+unsigned int sim::getState(void* handle)
+{
+    Task* task = handle == NULL ? current : (Task*) handle;
+    if (task == current)
+    {
+        return TASK_RUNNING;
+    }
+    if (task->code == NULL)
+    {
+        return TASK_DEAD;
+    }
+    if (task->suspended)
+    {
+        return TASK_SUSPENDED;
+    }
+    return task->state;
+}
+
+unsigned int sim::getTaskCount()
+{
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < MAX_TASKS; ++i)
+    {
+        if (tasks[i].code != NULL && tasks[i].state != TASK_DEAD)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+unsigned long sim::getTime()
+{
+    return now;
+}
+
+void sim::sleepUntil(unsigned long time)
+{
+    if (time <= now)
+    {
+        yield();
+        return;
+    }
+    current->state = TASK_SLEEPING;
+    current->lock = NULL;
+    current->wake = time;
+    block();
+}
+
+void sim::yield()
+{
+    if (current != NULL)
+    {
+        makeReady(current);
+        block();
+    }
+}
+
+void* sim::createLock(bool mutex)
+{
+    Lock* lock = new Lock;
+    lock->mutex = mutex;
+    // mutexes start out unlocked, and FreeRTOS binary semaphores made by
+    //  vSemaphoreCreateBinary() start out given
+    lock->available = true;
+    return lock;
+}
+
+void sim::deleteLock(void* lock)
+{
+    delete (Lock*) lock;
+}
+
+bool sim::take(void* handle, unsigned long timeout)
+{
+    Lock* lock = (Lock*) handle;
+    if (lock->available)
+    {
+        lock->available = false;
+        return true;
+    }
+    if (timeout == 0 || current == NULL)
+    {
+        return false;
+    }
+    current->state = TASK_SLEEPING;
+    current->lock = lock;
+    current->acquired = false;
+    current->order = orders++;
+    current->wake = timeout == SIM_FOREVER ? SIM_FOREVER :
+        now + timeout * 1000;
+    block();
+    return current->acquired;
+}
+
+bool sim::give(void* handle)
+{
+    Lock* lock = (Lock*) handle;
+    if (lock->available)
+    {
+        // binary semaphores can't be given twice
+        return false;
+    }
+    Task* waiter = pickWaiter(lock);
+    if (waiter == NULL)
+    {
+        lock->available = true;
+        return true;
+    }
+    // hand it straight over, so it stays taken
+    waiter->lock = NULL;
+    waiter->acquired = true;
+    makeReady(waiter);
+    preempt(waiter);
+    return true;
+}
+
+bool sim::runUntil(unsigned long end, bool (*done)())
+{
+    while (true)
+    {
+        Task* next = pickReady();
+        if (next != NULL)
+        {
+            current = next;
+            ++switches;
+            swapcontext(&scheduler, &next->context);
+            current = NULL;
+            reap();
+            if (done())
+            {
+                return true;
+            }
+            continue;
+        }
+        if (now >= end)
+        {
+            return false;
+        }
+        // nothing can run until time moves forward
+        now += SIM_STEP;
+        step();
+        for (unsigned int i = 0; i < MAX_TASKS; ++i)
+        {
+            Task* task = &tasks[i];
+            if (task->code != NULL && task->state == TASK_SLEEPING &&
+                task->wake <= now)
+            {
+                // a blocked take() timed out
+                task->lock = NULL;
+                makeReady(task);
+            }
+        }
+    }
+}
+
+unsigned long sim::getSwitches()
+{
+    return switches;
+}
@@ -0,0 +1,138 @@
+// runs one autonomous in the simulator and prints how it went
+//
+// usage: sim [options]
+//  -a <id>       autonomous to run, see auton::AutonID (default 0)
+//  -s <id>       script to run if the autonomous is SCRIPT
+//  -f <dir>      loads every file in a directory into the flash
+//  -o <dir>      saves every file in the flash to a directory afterwards
+//  -u <path>     sends everything written to uart2 to a file or serial port
+//  -t <ms>       length of the autonomous period (default 15000)
+//  -b <volts>    battery voltage (default 8.0)
+//  -p <left,right>  wheel slip on each side, from 0 to 1
+//  -n <counts>   standard deviation of the IME noise
+//  -r <seed>     seed for the noise
+//  -g            leaves the gyro port empty
+//  -l            prints the LCD whenever it changes
+//  -q            hides everything the robot code prints
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "sim.hpp"
+
+// wall clock time in seconds, to see how much faster than real time it ran
+static double now()
+{
+    struct timeval time;
+    gettimeofday(&time, NULL);
+    return time.tv_sec + time.tv_usec / 1000000.0;
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: sim [-a auton] [-s script] [-f dir] [-o dir] "
+        "[-u path] [-t ms] [-b volts] [-p left,right] [-n counts] "
+        "[-r seed] [-g] [-l] [-q]\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    sim::Config config;
+    sim::defaultConfig(config);
+    // where the flash gets saved to afterwards, if anywhere
+    const char* output = NULL;
+    int option;
+    while ((option = getopt(argc, argv, "a:s:f:o:u:t:b:p:n:r:glq")) != -1)
+    {
+        switch (option)
+        {
+        case 'a':
+            config.autonid = atoi(optarg);
+            break;
+        case 's':
+            config.scriptid = atoi(optarg);
+            break;
+        case 'f':
+            if (!sim::loadFiles(optarg))
+            {
+                fprintf(stderr, "couldn't open %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'u':
+            if (!sim::setUart2Output(optarg))
+            {
+                fprintf(stderr, "couldn't open %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            config.duration = strtoul(optarg, NULL, 10);
+            break;
+        case 'b':
+            config.battery = atof(optarg);
+            break;
+        case 'p':
+            if (sscanf(optarg, "%lf,%lf", &config.slipLeft,
+                &config.slipRight) != 2)
+            {
+                usage();
+            }
+            break;
+        case 'n':
+            config.imeNoise = atof(optarg);
+            break;
+        case 'g':
+            config.gyro = false;
+            break;
+        case 'r':
+            config.seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'l':
+            config.showLcd = true;
+            break;
+        case 'q':
+            config.quiet = true;
+            break;
+        default:
+            usage();
+        }
+    }
+    double start = now();
+    sim::Result result = sim::run(config);
+    double took = now() - start;
+    // the robot code's output might not have a newline at the end
+    fflush(stdout);
+    const char* ending = "ran out of time";
+    if (result.finished)
+    {
+        ending = result.timeouts + result.stalls > 0 ?
+            "finished after a failed wait" : "finished";
+    }
+    printf("\nauton %u %s in %lu ms (%.1f ms real, %lu task switches)\n",
+        config.autonid, ending, result.time, took * 1000, result.switches);
+    printf("waits: %u, %u timed out, %u stalled\n", result.waits,
+        result.timeouts, result.stalls);
+    printf("pose: x=%.2f y=%.2f heading=%.2f\n", result.x, result.y,
+        result.heading);
+    printf("odom: x=%.2f y=%.2f heading=%.2f (%s)\n", result.odomX,
+        result.odomY, result.odomHeading, result.gyroTrusted ?
+        "following the gyro" : "wheels only");
+    printf("lcd: %lu bytes, uart: %lu bytes\n", result.lcdBytes,
+        result.uartBytes);
+    printf("i2c: %lu IME transactions (%.1f per 20 ms)\n",
+        result.imeTransactions, result.time > 0 ?
+        result.imeTransactions * 20.0 / result.time : 0.0);
+    if (output != NULL && !sim::saveFiles(output))
+    {
+        fprintf(stderr, "couldn't save the flash to %s\n", output);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,218 @@
+// contains the moves that sweep -c compares, each done the way the robot
+//  code does it now and the way it used to before the controllers
+// they run in place of autonomous(), so they can use everything in src/
+
+#include "main.hpp"
+
+#include "sim.hpp"
+
+// how long each move gets, in ms, which includes holding it or coasting
+//  afterwards
+#define LIFT_MOVE_TIME 3000ul
+#define DRIVE_MOVE_TIME 5000ul
+// how close the lift has to stay to count as there, LIFT_TOLERANCE in
+//  motors.cpp
+#define LIFT_TOLERANCE 2.0
+
+// where each lift move goes, starting from the bottom
+static const double liftTargets[SIM_MOVE_COUNT] = { 63, 31, 126, 0 };
+static const char* liftNames[SIM_MOVE_COUNT] =
+{
+    "lift 0->63", "lift 63->31", "lift 31->126", "lift 126->0"
+};
+
+// how far each drive goes and how hard, one after the other
+static const long driveDistances[SIM_MOVE_COUNT] = { 300, 740, 500, 1200 };
+static const int drivePowers[SIM_MOVE_COUNT] = { 127, 127, -127, 127 };
+static const char* driveNames[SIM_MOVE_COUNT] =
+{
+    "drive 300", "drive 740", "drive 500 back", "drive 1200"
+};
+
+static bool old;
+static sim::MoveResult* results;
+
+// moves the lift to a target and watches it until LIFT_MOVE_TIME is up
+// the old way drives it at full power until it gets past the target and
+//  then lets go, like lift() did before the lift controller
+static sim::MoveResult moveLift(double target)
+{
+    sim::MoveResult result = { 0, 0, 0, 0 };
+    unsigned long start = millis();
+    unsigned long now = start;
+    bool up = target > motor::getLiftPos();
+    // still driving the old way
+    bool driving = old;
+    // when the lift last got within the tolerance, or 0 if it isn't
+    unsigned long inside = 0;
+    if (!old)
+    {
+        motor::setLiftTarget(target);
+    }
+    while (millis() - start < LIFT_MOVE_TIME)
+    {
+        double pos = motor::getLiftPos();
+        if (driving)
+        {
+            if (up ? pos < target : pos > target)
+            {
+                motor::setLift(up ? 127 : -127);
+            }
+            else
+            {
+                motor::setLift(0);
+                driving = false;
+            }
+        }
+        double past = up ? pos - target : target - pos;
+        if (past > result.overshoot)
+        {
+            result.overshoot = past;
+        }
+        if (fabs(target - pos) > LIFT_TOLERANCE)
+        {
+            inside = 0;
+        }
+        else if (inside == 0)
+        {
+            inside = millis();
+            if (result.reachTime == 0)
+            {
+                result.reachTime = inside - start;
+            }
+        }
+        taskDelayUntil(&now, MOTOR_POLL_RATE);
+    }
+    result.settleTime = inside != 0 ? inside - start : 0;
+    result.error = fabs(target - motor::getLiftPos());
+    return result;
+}
+
+// drives straight and watches the robot until DRIVE_MOVE_TIME is up, with
+//  how far it really went coming from the simulated world
+// the old way drives at full power until the left wheel has gone far
+//  enough and then lets go, like straight() did before motion profiles
+// it's there once straight() is done, and it's settled once it stops
+static sim::MoveResult moveDrive(long distance, int power)
+{
+    sim::MoveResult result = { 0, 0, 0, 0 };
+    unsigned long start = millis();
+    unsigned long now = start;
+    double startX;
+    double startY;
+    double heading;
+    sim::getTruePose(startX, startY, heading);
+    heading *= M_PI / 180;
+    units::Counts leftStart = motor::getLeftCounts();
+    bool driving = true;
+    auton::Handle handle;
+    if (old)
+    {
+        motor::setLeftDriveTrain(power);
+        motor::setRightDriveTrain(power);
+    }
+    else
+    {
+        handle = auton::straight(distance, power);
+    }
+    // when the robot stopped moving, or 0 if it's moving
+    unsigned long still = 0;
+    while (millis() - start < DRIVE_MOVE_TIME)
+    {
+        if (driving)
+        {
+            if (old)
+            {
+                driving = units::toSixteenths(units::abs(
+                    motor::getLeftCounts() - leftStart)).get() < distance;
+            }
+            else
+            {
+                // the executor moves the action along on its own
+                driving = !auton::isDone(handle);
+            }
+            if (!driving)
+            {
+                auton::stop();
+                result.reachTime = millis() - start;
+            }
+        }
+        double x;
+        double y;
+        double unused;
+        sim::getTruePose(x, y, unused);
+        // in 1/16 inches along the way it started out pointed
+        double gone = ((x - startX) * cos(heading) + (y - startY) *
+            sin(heading)) * 16 * (power < 0 ? -1 : 1);
+        if (gone - distance > result.overshoot)
+        {
+            result.overshoot = gone - distance;
+        }
+        result.error = fabs(gone - distance);
+        if (driving || motor::getLeftVelocity() != 0 ||
+            motor::getRightVelocity() != 0)
+        {
+            still = 0;
+        }
+        else if (still == 0)
+        {
+            still = millis();
+        }
+        taskDelayUntil(&now, MOTOR_POLL_RATE);
+    }
+    result.settleTime = still != 0 ? still - start : 0;
+    return result;
+}
+
+static void compareLift()
+{
+    for (unsigned int i = 0; i < SIM_MOVE_COUNT; ++i)
+    {
+        results[i] = moveLift(liftTargets[i]);
+    }
+}
+
+static void compareDrive()
+{
+    for (unsigned int i = 0; i < SIM_MOVE_COUNT; ++i)
+    {
+        results[i] = moveDrive(driveDistances[i], drivePowers[i]);
+    }
+}
+
+// declared in sim.hpp
+
+void sim::setupMoves(Config& config, Comparison comparison, bool oldWay,
+    MoveResult* moveResults)
+{
+    old = oldWay;
+    results = moveResults;
+    switch (comparison)
+    {
+    case COMPARE_LIFT:
+        config.routine = compareLift;
+        config.duration = SIM_MOVE_COUNT * LIFT_MOVE_TIME;
+        break;
+    case COMPARE_DRIVE:
+        config.routine = compareDrive;
+        config.duration = SIM_MOVE_COUNT * DRIVE_MOVE_TIME;
+        break;
+    default:
+        config.routine = NULL;
+    }
+    // the routine and initialize() both need a bit more than the moves
+    config.duration += 1000;
+}
+
+const char* sim::getMoveName(Comparison comparison, unsigned int move)
+{
+    switch (comparison)
+    {
+    case COMPARE_LIFT:
+        return liftNames[move];
+    case COMPARE_DRIVE:
+        return driveNames[move];
+    default:
+        return "";
+    }
+}
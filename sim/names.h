@@ -0,0 +1,29 @@
+// included before everything that's compiled against API.h in the simulator
+// API.h declares its own versions of some C library functions, so they get
+//  renamed here to keep them from clashing with the host's C library
+
+#ifndef SIM_NAMES_H
+#define SIM_NAMES_H
+
+#define fclose simFclose
+#define feof simFeof
+#define fflush simFflush
+#define fgetc simFgetc
+#define fgets simFgets
+#define fopen simFopen
+#define fprintf simFprintf
+#define fputc simFputc
+#define fputs simFputs
+#define fread simFread
+#define fseek simFseek
+#define ftell simFtell
+#define fwrite simFwrite
+#define getchar simGetchar
+#define printf simPrintf
+#define putchar simPutchar
+#define puts simPuts
+#define snprintf simSnprintf
+#define sprintf simSprintf
+#define wait simWait
+
+#endif // SIM_NAMES_H
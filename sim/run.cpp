@@ -0,0 +1,123 @@
+// contains what runs the robot code in the simulator the same way the
+//  cortex would during a match: initializeIO(), initialize(), then
+//  autonomous() in its own task until it returns or the period ends
+
+#include "main.hpp"
+
+#include "sim.hpp"
+
+// how long the robot gets to notice it's disabled after the period ends, in
+//  microseconds
+#define DISABLE_TIME 200000ul
+
+static void (*routine)() = NULL;
+static bool autonomousDone = false;
+static unsigned long autonomousStart;
+static unsigned long autonomousEnd;
+// IME transactions when the autonomous started and ended
+static unsigned long imeStart;
+static unsigned long imeEnd;
+
+// the competition task, which is what runs the user functions on the cortex
+static void competition(void*)
+{
+    initialize();
+    sim::setCompetition(true, true);
+    autonomousStart = millis();
+    imeStart = sim::getImeTransactions();
+    if (routine != NULL)
+    {
+        routine();
+    }
+    else
+    {
+        autonomous();
+    }
+    autonomousEnd = millis();
+    imeEnd = sim::getImeTransactions();
+    autonomousDone = true;
+}
+
+static bool isDone()
+{
+    return autonomousDone;
+}
+
+static bool isNeverDone()
+{
+    return false;
+}
+
+// declared in sim.hpp
+
+void sim::defaultConfig(Config& config)
+{
+    config.autonid = auton::NOTHING;
+    config.scriptid = 0;
+    config.duration = 15000;
+    config.battery = 8.0;
+    for (unsigned int i = 0; i < SIM_PORT_COUNT; ++i)
+    {
+        config.strength[i] = 1;
+    }
+    config.slipLeft = 0;
+    config.slipRight = 0;
+    config.imeNoise = 0;
+    config.gyro = true;
+    config.seed = 1;
+    config.quiet = false;
+    config.showLcd = false;
+    config.routine = NULL;
+}
+
+sim::Result sim::run(const Config& config)
+{
+    initWorld(config);
+    setQuiet(config.quiet);
+    setShowLcd(config.showLcd);
+    setCompetition(false, false);
+    auton::autonid = (auton::AutonID) config.autonid;
+    auton::scriptid = config.scriptid;
+    routine = config.routine;
+    initializeIO();
+    createTask(competition, NULL, TASK_PRIORITY_DEFAULT);
+    Result result;
+    result.finished = runUntil(config.duration * 1000, isDone);
+    result.time = (autonomousDone ? autonomousEnd : millis()) -
+        autonomousStart;
+    getTruePose(result.x, result.y, result.heading);
+    odom::Pose pose = odom::getPose();
+    result.odomX = odom::toSixteenths(pose.x) / 16.0;
+    result.odomY = odom::toSixteenths(pose.y) / 16.0;
+    result.odomHeading = (double) pose.heading * 360 / HEADING_PER_REV;
+    result.gyroTrusted = odom::isGyroTrusted();
+    result.switches = getSwitches();
+    result.lcdBytes = getLcdBytes();
+    result.uartBytes = getUartBytes();
+    result.imeTransactions = (autonomousDone ? imeEnd :
+        getImeTransactions()) - imeStart;
+    result.timeouts = 0;
+    result.stalls = 0;
+    const auton::WaitRecord* waits = auton::getWaitLog(&result.waits);
+    for (unsigned int i = 0; i < result.waits; ++i)
+    {
+        if (waits[i].result == auton::WAIT_TIMEOUT)
+        {
+            ++result.timeouts;
+        }
+        else if (waits[i].result == auton::WAIT_STALLED)
+        {
+            ++result.stalls;
+        }
+    }
+    // disable the robot like the field does at the end of the period, so
+    //  anything that's being written to the flash gets closed
+    setCompetition(false, true);
+    runUntil(getTime() + DISABLE_TIME, isNeverDone);
+    return result;
+}
+
+unsigned int sim::getAutonCount()
+{
+    return auton::AUTONID_MAX + 1;
+}
@@ -0,0 +1,211 @@
+// declares everything in the simulator that's shared between the simulated
+//  API.h (api.cpp), the robot runner (run.cpp) and the plain host code
+// this can't include API.h or any of the C library's stdio stuff, since
+//  files on both sides of that line include it
+
+#ifndef SIM_HPP
+#define SIM_HPP
+
+#include <stdarg.h>
+#include <stddef.h>
+
+// motor ports on the cortex, numbered from 1
+#define SIM_PORT_COUNT 10
+// digital pins on the cortex, numbered from 1
+#define SIM_PIN_COUNT 12
+// how long each physics step is, in microseconds
+#define SIM_STEP 1000ul
+// what a block time of -1 (forever) turns into
+#define SIM_FOREVER ((unsigned long) -1)
+// moves in each of sweep's comparisons
+#define SIM_MOVE_COUNT 4
+
+namespace sim
+{
+// what the simulated robot and field look like for one run
+struct Config
+{
+    // which autonomous to run, see auton::AutonID
+    unsigned int autonid;
+    unsigned int scriptid;
+    // how long the autonomous period is, in ms
+    unsigned long duration;
+    // resting battery voltage
+    double battery;
+    // how much torque each motor port puts out compared to a normal 393
+    double strength[SIM_PORT_COUNT];
+    // fraction of wheel movement that's lost to slipping on each side
+    double slipLeft;
+    double slipRight;
+    // standard deviation of the noise on every IME count reading
+    double imeNoise;
+    // whether there's a gyro plugged in, an empty port still initializes
+    //  but never turns
+    bool gyro;
+    // seeds the noise so runs can be repeated
+    unsigned long seed;
+    // keeps the robot code's printf()s from going anywhere
+    bool quiet;
+    // prints the virtual LCD every time it changes
+    bool showLcd;
+    // runs instead of autonomous() if it isn't NULL
+    void (*routine)();
+};
+
+// what happened during one run
+struct Result
+{
+    // whether the autonomous function returned before the period ended
+    bool finished;
+    // how long the autonomous took, in ms of virtual time
+    unsigned long time;
+    // where the robot actually ended up, in inches and degrees from where
+    //  it started (x is forward, counterclockwise is positive)
+    double x;
+    double y;
+    double heading;
+    // where the odometry thinks it ended up, in the same units
+    double odomX;
+    double odomY;
+    double odomHeading;
+    // whether the odometry ended up following the gyro
+    bool gyroTrusted;
+    // how many task switches the kernel did
+    unsigned long switches;
+    // bytes written to the LCD and the other UARTs
+    unsigned long lcdBytes;
+    unsigned long uartBytes;
+    // IME reads and resets during the autonomous, each one is an I2C
+    //  transaction on the cortex
+    unsigned long imeTransactions;
+    // how many times the routine waited on something, and how many of those
+    //  gave up because they took too long or it got stuck
+    // a routine that finished with any of these didn't do everything it was
+    //  supposed to, either skipping ahead or returning early
+    unsigned int waits;
+    unsigned int timeouts;
+    unsigned int stalls;
+};
+
+// what happened during one move of a comparison
+struct MoveResult
+{
+    // how long it took to first get to the target, in ms, or 0 if it never
+    //  did
+    unsigned long reachTime;
+    // how long it took to get to the target and stay there, in ms, or 0 if
+    //  it never did
+    unsigned long settleTime;
+    // how far from the target it ended up, and the furthest past it that it
+    //  went
+    double error;
+    double overshoot;
+};
+
+// what sweep -c can compare
+enum Comparison
+{
+    // bang-bang lift() against the lift controller
+    COMPARE_LIFT,
+    // open loop straight() against motion profiles
+    COMPARE_DRIVE,
+    COMPARISON_COUNT
+};
+
+// fills in a Config with a normal robot on a full battery
+void defaultConfig(Config& config);
+
+// runs one autonomous from a fresh start, only ever call this once per
+//  process since the robot code keeps its state in globals
+Result run(const Config& config);
+// how many autonomous routines there are, including NOTHING
+unsigned int getAutonCount();
+
+// moves.cpp, sets a Config up to do one comparison's moves the old way or
+//  the new way, putting what happened in results
+void setupMoves(Config& config, Comparison comparison, bool old,
+    MoveResult* results);
+const char* getMoveName(Comparison comparison, unsigned int move);
+
+// kernel.cpp, a cooperative FreeRTOS stand-in where time only moves when
+//  every task is waiting on something
+typedef void (*TaskCode)(void*);
+void* createTask(TaskCode code, void* param, unsigned int priority);
+// NULL means the current task
+void deleteTask(void* task);
+void suspendTask(void* task);
+void resumeTask(void* task);
+void* getCurrentTask();
+unsigned int getPriority(void* task);
+void setPriority(void* task, unsigned int priority);
+// one of the TASK_* states in API.h
+unsigned int getState(void* task);
+unsigned int getTaskCount();
+// virtual time, in microseconds
+unsigned long getTime();
+// blocks the current task until a time in microseconds
+void sleepUntil(unsigned long time);
+// lets other tasks with the same priority run
+void yield();
+// binary semaphores and mutexes, timeouts are in ms
+void* createLock(bool mutex);
+void deleteLock(void* lock);
+bool take(void* lock, unsigned long timeout);
+bool give(void* lock);
+// runs tasks until done returns true or the virtual time gets to end
+bool runUntil(unsigned long end, bool (*done)());
+unsigned long getSwitches();
+
+// world.cpp, the robot's physics
+void initWorld(const Config& config);
+// moves everything forward by one SIM_STEP
+void step();
+void setMotor(unsigned char port, int speed);
+int getMotor(unsigned char port);
+bool readPin(unsigned char pin);
+void writePin(unsigned char pin, bool value);
+unsigned int getImeCount();
+bool readIme(unsigned char address, int* counts, int* velocity);
+bool resetIme(unsigned char address);
+// in millivolts, including the sag from whatever the motors are pulling
+unsigned int getBatteryLevel();
+// the gyro's heading in degrees, counterclockwise is positive
+double getGyroHeading();
+// where the robot actually is, in inches and degrees
+void getTruePose(double& x, double& y, double& heading);
+
+// api.cpp, called after every step so pin interrupts happen
+void checkInterrupts();
+// what isEnabled() and isAutonomous() say
+void setCompetition(bool enabled, bool autonomous);
+// how many imeGet(), imeGetVelocity() and imeReset() calls there have been
+unsigned long getImeTransactions();
+
+// io.cpp, the host side of files, UARTs and the LCD
+int format(char* buffer, size_t size, const char* fmt, va_list args);
+void setQuiet(bool quiet);
+void setShowLcd(bool show);
+// stream is 1 for uart1, 2 for uart2 and 3 for the terminal
+void writeStream(int stream, const char* data, size_t size);
+unsigned long getUartBytes();
+// sends everything written to uart2 to a file or a serial port (or a pty)
+bool setUart2Output(const char* path);
+void setLcdLine(unsigned char line, const char* text);
+const char* getLcdLine(unsigned char line);
+unsigned long getLcdBytes();
+// the cortex's flash file system
+bool loadFiles(const char* directory);
+// writes every file in the flash to a directory
+bool saveFiles(const char* directory);
+int openFile(const char* name, const char* mode);
+void closeFile(int file);
+size_t readFile(int file, void* data, size_t size);
+size_t writeFile(int file, const void* data, size_t size);
+int seekFile(int file, long offset, int origin);
+long tellFile(int file);
+bool isFileEnd(int file);
+int countFile(int file);
+int deleteFile(const char* name);
+} // end namespace sim
+
+#endif // SIM_HPP
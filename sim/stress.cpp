@@ -0,0 +1,264 @@
+// stress tests the lock-free shared state from main.hpp with real threads on
+//  the host, which gets a lot more reads and writes in at awkward times than
+//  the cortex ever would
+//
+// usage: stress [options]
+//  -t <ms>       how long each test runs (default 2000)
+//  -r <readers>  reader threads in each test (default 7)
+//  -s <setters>  threads setting the Target at the same time (default 4)
+//
+// the Seqlock test has one writer publishing a struct with every field set
+//  to the same count, and readers fail if the fields ever disagree or the
+//  count goes backwards
+// the Target test has every setter set its own values, and readers fail if
+//  they see a value nobody set or the generation goes backwards
+// it also fails at the end if the generation doesn't match how many sets
+//  there were, which would mean the compare and swap lost one, or if setting
+//  a value that's out of range doesn't clamp it
+// the MotorFrame test has setters setting a group of motors while one thread
+//  flushes, and fails if a flush ever sends the group different speeds
+
+#include "main.hpp"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define MAX_THREADS 64
+// fields in what the Seqlock test publishes, big enough that a copy of it
+//  can get interrupted halfway through
+#define SAMPLE_WORDS 16
+
+struct Sample
+{
+    unsigned long count[SAMPLE_WORDS];
+};
+
+// what each thread did, filled in by the thread
+struct Tally
+{
+    // which thread it is, out of the writers or setters and then the readers
+    unsigned int index;
+    unsigned long reads;
+    unsigned long sets;
+    unsigned long errors;
+};
+
+// the group the MotorFrame test sets, like the lift's 4 motors
+typedef motor::MotorGroup<1, -2, 3, -4> Group;
+
+static shared::Seqlock<Sample> seqlock;
+static shared::Target target;
+static motor::MotorFrame frame(Group::getInverted());
+static unsigned int setterCount = 4;
+// set once the time is up, every thread checks it every time around
+static volatile bool stopping;
+
+static void* seqlockWriter(void* arg)
+{
+    Tally* tally = (Tally*) arg;
+    Sample sample;
+    for (unsigned long count = 1; !stopping; ++count)
+    {
+        for (unsigned int i = 0; i < SAMPLE_WORDS; ++i)
+        {
+            sample.count[i] = count;
+        }
+        seqlock.write(sample);
+        ++tally->sets;
+    }
+    return NULL;
+}
+
+static void* seqlockReader(void* arg)
+{
+    Tally* tally = (Tally*) arg;
+    unsigned long last = 0;
+    while (!stopping)
+    {
+        Sample sample = seqlock.read();
+        for (unsigned int i = 1; i < SAMPLE_WORDS; ++i)
+        {
+            if (sample.count[i] != sample.count[0])
+            {
+                ++tally->errors;
+                break;
+            }
+        }
+        if (sample.count[0] < last)
+        {
+            ++tally->errors;
+        }
+        last = sample.count[0];
+        ++tally->reads;
+    }
+    return NULL;
+}
+
+// setter n sets n + 1 and -(n + 1) one after the other, so the sign bit
+//  keeps changing too
+static void* targetSetter(void* arg)
+{
+    Tally* tally = (Tally*) arg;
+    int value = (int) tally->index + 1;
+    while (!stopping)
+    {
+        target.set(tally->sets & 1 ? -value : value);
+        ++tally->sets;
+    }
+    return NULL;
+}
+
+static void* targetReader(void* arg)
+{
+    Tally* tally = (Tally*) arg;
+    unsigned int last = 0;
+    while (!stopping)
+    {
+        unsigned int generation;
+        double value = target.get(generation);
+        double size = fabs(value);
+        // every set value is a whole number, and it's only 0 before the
+        //  first set
+        bool valid = generation == 0 ? value == 0 : size >= 1 &&
+            size <= setterCount && size == floor(size);
+        if (!valid || generation < last)
+        {
+            ++tally->errors;
+        }
+        last = generation;
+        ++tally->reads;
+    }
+    return NULL;
+}
+
+// setter n sets its group to n + 1 and -(n + 1) one after the other, like
+//  targetSetter()
+static void* groupSetter(void* arg)
+{
+    Tally* tally = (Tally*) arg;
+    int value = (int) tally->index + 1;
+    while (!stopping)
+    {
+        Group::set(frame, tally->sets & 1 ? -value : value);
+        ++tally->sets;
+    }
+    return NULL;
+}
+
+// there's only ever one of these, since only one task flushes
+static void* groupFlusher(void* arg)
+{
+    Tally* tally = (Tally*) arg;
+    while (!stopping)
+    {
+        frame.flush();
+        int first = frame.getOutput(1);
+        for (unsigned char port = 2; port <= 4; ++port)
+        {
+            if (frame.getOutput(port) != first)
+            {
+                ++tally->errors;
+                break;
+            }
+        }
+        ++tally->reads;
+    }
+    return NULL;
+}
+
+// runs the writers and readers for a while, returns the totals
+static Tally runThreads(void* (*writer)(void*), unsigned int writers,
+    void* (*reader)(void*), unsigned int readers, unsigned long time)
+{
+    pthread_t threads[MAX_THREADS];
+    Tally tallies[MAX_THREADS];
+    unsigned int count = writers + readers;
+    stopping = false;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        Tally blank = { i, 0, 0, 0 };
+        tallies[i] = blank;
+        pthread_create(&threads[i], NULL, i < writers ? writer : reader,
+            &tallies[i]);
+    }
+    usleep(time * 1000);
+    stopping = true;
+    Tally total = { count, 0, 0, 0 };
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        total.reads += tallies[i].reads;
+        total.sets += tallies[i].sets;
+        total.errors += tallies[i].errors;
+    }
+    return total;
+}
+
+static void usage()
+{
+    printf("usage: stress [-t ms] [-r readers] [-s setters]\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long time = 2000;
+    unsigned int readers = 7;
+    int option;
+    while ((option = getopt(argc, argv, "t:r:s:")) != -1)
+    {
+        switch (option)
+        {
+        case 't':
+            time = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            readers = atoi(optarg);
+            break;
+        case 's':
+            setterCount = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    // Target values have to fit between -128 and 127
+    if (readers + setterCount + 1 > MAX_THREADS || setterCount < 1 ||
+        setterCount > 127)
+    {
+        usage();
+    }
+    bool failed = false;
+    Tally seqlockTotal = runThreads(seqlockWriter, 1, seqlockReader, readers,
+        time);
+    printf("seqlock: %lu writes, %lu reads, %lu torn or out of order\n",
+        seqlockTotal.sets, seqlockTotal.reads, seqlockTotal.errors);
+    failed = failed || seqlockTotal.errors > 0;
+    Tally targetTotal = runThreads(targetSetter, setterCount, targetReader,
+        readers, time);
+    // getGeneration() is an unsigned int, so the count wraps the same way
+    unsigned int lost = (unsigned int) targetTotal.sets -
+        target.getGeneration();
+    printf("target: %lu sets, %lu reads, %lu bad values or generations, "
+        "%u sets lost\n", targetTotal.sets, targetTotal.reads,
+        targetTotal.errors, lost);
+    failed = failed || targetTotal.errors > 0 || lost != 0;
+    // anything out of range should get clamped instead of wrapping around
+    target.set(1000);
+    double high = target.get();
+    target.set(-1000);
+    double low = target.get();
+    bool clamped = high > 127 && high < 128 && low == -128;
+    printf("target: out of range sets %s\n", clamped ? "clamped" :
+        "wrapped around");
+    failed = failed || !clamped;
+    Tally frameTotal = runThreads(groupSetter, setterCount, groupFlusher, 1,
+        time);
+    printf("frame: %lu group sets, %lu flushes, %lu with the group split\n",
+        frameTotal.sets, frameTotal.reads, frameTotal.errors);
+    failed = failed || frameTotal.errors > 0;
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
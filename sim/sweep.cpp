@@ -0,0 +1,532 @@
+// runs autonomous routines thousands of times in the simulator with a
+//  slightly different robot every time, then prints how long they took and
+//  where they ended up
+//
+// usage: sweep [options]
+//  -a <id,id,...>  autonomous routines to run (default all of them)
+//  -c <name,...>   instead compares moves done the old way and the new way
+//                  on the same robots, see sim::Comparison (lift, drive)
+//  -n <runs>       runs per routine (default 1000)
+//  -j <workers>    how many runs happen at once (default one per core)
+//  -f <dir>        loads every file in a directory into the flash
+//  -r <seed>       seed for the first run, every other run is seed + i
+//
+// the robot code keeps everything in globals, so every run happens in its
+//  own fork() of a process that hasn't run anything yet
+// each worker starts with an even share of the runs, and a worker that
+//  runs out steals half of what's left from whichever worker has the most
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "sim.hpp"
+
+#define MAX_WORKERS 256
+
+// a range of runs that one worker still has to do, packed into one word
+//  so it can be changed with a single compare and swap
+// the owner takes runs off the end and thieves take them off the start
+struct Queue
+{
+    volatile unsigned long long range;
+    // how many times this worker stole from someone else
+    volatile unsigned long steals;
+};
+
+// one run of one routine, or of one way of doing a comparison's moves
+struct Job
+{
+    unsigned int autonid;
+    // the comparison, or COMPARISON_COUNT if it's running autonid
+    unsigned int comparison;
+    bool old;
+    unsigned long seed;
+    // set by the run's process once result is filled in
+    volatile bool done;
+    sim::Result result;
+    sim::MoveResult moves[SIM_MOVE_COUNT];
+};
+
+// what -c takes, in the same order as sim::Comparison
+static const char* comparisonNames[sim::COMPARISON_COUNT] =
+{
+    "lift", "drive"
+};
+
+static unsigned long long pack(unsigned long start, unsigned long end)
+{
+    return ((unsigned long long) start << 32) | end;
+}
+
+static unsigned long getStart(unsigned long long range)
+{
+    return range >> 32;
+}
+
+static unsigned long getEnd(unsigned long long range)
+{
+    return range & 0xffffffff;
+}
+
+// xorshift, so the random robots only depend on the seed
+static double uniform(unsigned long long& state)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return ((state * 2685821657736338717ull) >> 11) / 9007199254740992.0;
+}
+
+static double uniform(unsigned long long& state, double min, double max)
+{
+    return min + (max - min) * uniform(state);
+}
+
+// makes up a robot for a run
+static void randomize(sim::Config& config, unsigned long seed)
+{
+    unsigned long long state = seed * 0x9e3779b97f4a7c15ull + 1;
+    // motors wear out and PTCs warm up, so some are weaker than others
+    for (unsigned int i = 0; i < SIM_PORT_COUNT; ++i)
+    {
+        config.strength[i] = uniform(state, 0.85, 1.05);
+    }
+    config.battery = uniform(state, 7.4, 8.4);
+    config.slipLeft = uniform(state, 0, 0.08);
+    config.slipRight = uniform(state, 0, 0.08);
+    config.imeNoise = uniform(state, 0, 2);
+    config.seed = seed;
+}
+
+// runs one job in a fresh copy of this process
+static void run(Job& job, const sim::Config& base)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        sim::Config config = base;
+        config.autonid = job.autonid;
+        randomize(config, job.seed);
+        if (job.comparison < sim::COMPARISON_COUNT)
+        {
+            sim::setupMoves(config, (sim::Comparison) job.comparison,
+                job.old, job.moves);
+        }
+        job.result = sim::run(config);
+        __sync_synchronize();
+        job.done = true;
+        _exit(0);
+    }
+    if (pid > 0)
+    {
+        int status;
+        waitpid(pid, &status, 0);
+    }
+}
+
+// takes the next run off the end of a worker's own queue
+static bool take(Queue& queue, unsigned long& job)
+{
+    while (true)
+    {
+        unsigned long long range = queue.range;
+        unsigned long start = getStart(range);
+        unsigned long end = getEnd(range);
+        if (start >= end)
+        {
+            return false;
+        }
+        if (__sync_bool_compare_and_swap(&queue.range, range,
+            pack(start, end - 1)))
+        {
+            job = end - 1;
+            return true;
+        }
+    }
+}
+
+// takes half of the runs off the start of the fullest queue and makes them
+//  the thief's own, returns false once there's nothing left anywhere
+static bool steal(Queue* queues, unsigned int workers, unsigned int thief)
+{
+    while (true)
+    {
+        unsigned int victim = workers;
+        unsigned long most = 0;
+        for (unsigned int i = 0; i < workers; ++i)
+        {
+            unsigned long long range = queues[i].range;
+            unsigned long left = getEnd(range) - getStart(range);
+            if (getStart(range) < getEnd(range) && left > most)
+            {
+                victim = i;
+                most = left;
+            }
+        }
+        if (victim == workers)
+        {
+            return false;
+        }
+        unsigned long long range = queues[victim].range;
+        unsigned long start = getStart(range);
+        unsigned long end = getEnd(range);
+        if (start >= end)
+        {
+            continue;
+        }
+        // leave the victim the half it's about to work on
+        unsigned long count = (end - start + 1) / 2;
+        if (__sync_bool_compare_and_swap(&queues[victim].range, range,
+            pack(start + count, end)))
+        {
+            // nobody steals from an empty queue, so this can't race
+            queues[thief].range = pack(start, start + count);
+            ++queues[thief].steals;
+            return true;
+        }
+    }
+}
+
+static void work(Queue* queues, unsigned int workers, unsigned int self,
+    Job* jobs, const sim::Config& base)
+{
+    unsigned long job;
+    do
+    {
+        while (take(queues[self], job))
+        {
+            run(jobs[job], base);
+        }
+    }
+    while (steal(queues, workers, self));
+}
+
+static double now()
+{
+    struct timeval time;
+    gettimeofday(&time, NULL);
+    return time.tv_sec + time.tv_usec / 1000000.0;
+}
+
+// the value that a fraction of the sorted values are below
+static double percentile(const std::vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    size_t index = (size_t) (fraction * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static void summarize(const char* name, std::vector<double>& values)
+{
+    if (values.empty())
+    {
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    double mean = 0;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        mean += values[i];
+    }
+    mean /= values.size();
+    double variance = 0;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        variance += (values[i] - mean) * (values[i] - mean);
+    }
+    variance /= values.size();
+    printf("  %-10s mean %9.2f  sd %8.2f  min %9.2f  p5 %9.2f  p50 %9.2f  "
+        "p95 %9.2f  max %9.2f\n", name, mean, sqrt(variance), values.front(),
+        percentile(values, 0.05), percentile(values, 0.5),
+        percentile(values, 0.95), values.back());
+}
+
+// returns how many runs of the routine didn't finish in the period
+static unsigned long report(unsigned int autonid, const Job* jobs,
+    unsigned long count)
+{
+    std::vector<double> times;
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> headings;
+    // how far off the odometry was at the end
+    std::vector<double> odomErrors;
+    // IME I2C transactions per 20 ms of autonomous
+    std::vector<double> imeRates;
+    unsigned long finished = 0;
+    // finished, but only after giving up on something along the way
+    unsigned long failed = 0;
+    unsigned long crashed = 0;
+    unsigned long waits = 0;
+    unsigned long timeouts = 0;
+    unsigned long stalls = 0;
+    for (unsigned long i = 0; i < count; ++i)
+    {
+        const Job& job = jobs[i];
+        if (job.comparison < sim::COMPARISON_COUNT || job.autonid != autonid)
+        {
+            continue;
+        }
+        if (!job.done)
+        {
+            ++crashed;
+            continue;
+        }
+        const sim::Result& result = job.result;
+        waits += result.waits;
+        timeouts += result.timeouts;
+        stalls += result.stalls;
+        if (result.finished && result.timeouts + result.stalls > 0)
+        {
+            ++failed;
+        }
+        else if (result.finished)
+        {
+            ++finished;
+            times.push_back(result.time);
+        }
+        xs.push_back(result.x);
+        ys.push_back(result.y);
+        headings.push_back(result.heading);
+        odomErrors.push_back(hypot(result.odomX - result.x,
+            result.odomY - result.y));
+        if (result.time > 0)
+        {
+            imeRates.push_back(result.imeTransactions * 20.0 / result.time);
+        }
+    }
+    unsigned long runs = xs.size() + crashed;
+    unsigned long overran = xs.size() - finished - failed;
+    printf("auton %u: %lu runs, %lu finished in time, %lu finished after a "
+        "failed wait, %lu ran out of time, %lu crashed\n", autonid, runs,
+        finished, failed, overran, crashed);
+    printf("  %.1f%% of runs failed, %lu waits: %.2f%% timed out, %.2f%% "
+        "stalled\n", runs > 0 ? 100.0 * (runs - finished) / runs : 0.0,
+        waits, waits > 0 ? 100.0 * timeouts / waits : 0.0,
+        waits > 0 ? 100.0 * stalls / waits : 0.0);
+    summarize("time (ms)", times);
+    summarize("x (in)", xs);
+    summarize("y (in)", ys);
+    summarize("heading", headings);
+    summarize("odom err", odomErrors);
+    summarize("i2c/20ms", imeRates);
+    return overran;
+}
+
+// prints how each move went the old way and the new way
+static void compare(unsigned int comparison, const Job* jobs,
+    unsigned long count)
+{
+    printf("%s, old way against new way:\n", comparisonNames[comparison]);
+    for (unsigned int move = 0; move < SIM_MOVE_COUNT; ++move)
+    {
+        printf("%s\n", sim::getMoveName((sim::Comparison) comparison, move));
+        for (int old = 1; old >= 0; --old)
+        {
+            std::vector<double> reachTimes;
+            std::vector<double> settleTimes;
+            std::vector<double> errors;
+            std::vector<double> overshoots;
+            unsigned long runs = 0;
+            for (unsigned long i = 0; i < count; ++i)
+            {
+                const Job& job = jobs[i];
+                if (job.comparison != comparison || job.old != (old != 0) ||
+                    !job.done)
+                {
+                    continue;
+                }
+                ++runs;
+                const sim::MoveResult& result = job.moves[move];
+                if (result.reachTime > 0)
+                {
+                    reachTimes.push_back(result.reachTime);
+                }
+                if (result.settleTime > 0)
+                {
+                    settleTimes.push_back(result.settleTime);
+                }
+                errors.push_back(result.error);
+                overshoots.push_back(result.overshoot);
+            }
+            printf(" %s: got there and stayed in %lu/%lu runs\n",
+                old ? "old" : "new", (unsigned long) settleTimes.size(),
+                runs);
+            summarize("reach ms", reachTimes);
+            summarize("settle ms", settleTimes);
+            summarize("end error", errors);
+            summarize("overshoot", overshoots);
+        }
+    }
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: sweep [-a id,id,...] [-c name,...] [-n runs] "
+        "[-j workers] [-f dir] [-r seed]\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<unsigned int> autons;
+    std::vector<unsigned int> comparisons;
+    unsigned long runs = 1000;
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned long seed = 1;
+    sim::Config base;
+    sim::defaultConfig(base);
+    base.quiet = true;
+    int option;
+    while ((option = getopt(argc, argv, "a:c:n:j:f:r:")) != -1)
+    {
+        switch (option)
+        {
+        case 'a':
+            for (char* id = strtok(optarg, ","); id != NULL;
+                id = strtok(NULL, ","))
+            {
+                autons.push_back(atoi(id));
+            }
+            break;
+        case 'c':
+            for (char* name = strtok(optarg, ","); name != NULL;
+                name = strtok(NULL, ","))
+            {
+                unsigned int i = 0;
+                while (i < sim::COMPARISON_COUNT &&
+                    strcmp(name, comparisonNames[i]) != 0)
+                {
+                    ++i;
+                }
+                if (i == sim::COMPARISON_COUNT)
+                {
+                    usage();
+                }
+                comparisons.push_back(i);
+            }
+            break;
+        case 'n':
+            runs = strtoul(optarg, NULL, 10);
+            break;
+        case 'j':
+            workers = atol(optarg);
+            break;
+        case 'f':
+            if (!sim::loadFiles(optarg))
+            {
+                fprintf(stderr, "couldn't open %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'r':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (autons.empty() && comparisons.empty())
+    {
+        // NOTHING doesn't need to be timed
+        for (unsigned int i = 1; i < sim::getAutonCount(); ++i)
+        {
+            autons.push_back(i);
+        }
+    }
+    if (workers < 1)
+    {
+        workers = 1;
+    }
+    else if (workers > MAX_WORKERS)
+    {
+        workers = MAX_WORKERS;
+    }
+    // every comparison runs each robot twice, once each way
+    unsigned long count = runs * (autons.size() + 2 * comparisons.size());
+    // shared with every worker and every run
+    Job* jobs = (Job*) mmap(NULL, count * sizeof(Job),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    Queue* queues = (Queue*) mmap(NULL, workers * sizeof(Queue),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (jobs == MAP_FAILED || queues == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+    unsigned long autonCount = runs * autons.size();
+    for (unsigned long i = 0; i < count; ++i)
+    {
+        Job& job = jobs[i];
+        job.autonid = 0;
+        job.comparison = sim::COMPARISON_COUNT;
+        job.old = false;
+        job.seed = seed + i;
+        job.done = false;
+        if (i < autonCount)
+        {
+            // mix the routines up so every worker gets some of each
+            job.autonid = autons[i % autons.size()];
+            continue;
+        }
+        // both ways get the same robots
+        unsigned long run = (i - autonCount) / 2;
+        job.comparison = comparisons[run % comparisons.size()];
+        job.old = (i - autonCount) % 2 == 0;
+        job.seed = seed + run / comparisons.size();
+    }
+    for (long i = 0; i < workers; ++i)
+    {
+        queues[i].range = pack(count * i / workers, count * (i + 1) / workers);
+        queues[i].steals = 0;
+    }
+    // nothing that's printed before the fork should get printed twice
+    fflush(stdout);
+    double start = now();
+    for (long i = 0; i < workers; ++i)
+    {
+        if (fork() == 0)
+        {
+            work(queues, workers, i, jobs, base);
+            _exit(0);
+        }
+    }
+    while (wait(NULL) > 0)
+    {
+    }
+    double took = now() - start;
+    unsigned long steals = 0;
+    for (long i = 0; i < workers; ++i)
+    {
+        steals += queues[i].steals;
+    }
+    printf("%lu runs on %ld workers in %.2f s (%.0f runs/s, %lu steals)\n\n",
+        count, workers, took, count / took, steals);
+    // a routine that doesn't fit in the period never gets to its last steps
+    unsigned long overran = 0;
+    for (size_t i = 0; i < autons.size(); ++i)
+    {
+        overran += report(autons[i], jobs, count);
+    }
+    for (size_t i = 0; i < comparisons.size(); ++i)
+    {
+        compare(comparisons[i], jobs, count);
+    }
+    if (overran > 0)
+    {
+        printf("\n%lu runs ran out of time\n", overran);
+        return 1;
+    }
+    return 0;
+}
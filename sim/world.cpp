@@ -0,0 +1,355 @@
+// contains the physics of the simulated robot
+// every mechanism is a shaft driven by 393 motors, with its position in
+//  radians of the motor's output shaft, which is also what the IMEs measure
+// the wiring and robot measurements in here have to match src/motors.cpp
+//  and include/main.hpp, the robot code doesn't know it's being simulated
+
+#include <math.h>
+
+#include "sim.hpp"
+
+// 393 motors in high torque mode
+#define NOMINAL_VOLTAGE 7.2
+#define STALL_TORQUE 1.67 // N*m
+#define STALL_CURRENT 4.8 // A
+#define FREE_SPEED (100 * 2 * M_PI / 60) // rad/s
+// what the battery voltage drops by per amp pulled from it
+#define BATTERY_RESISTANCE 0.05
+
+// IME counts per output revolution and velocity units per rpm, see API.h
+#define COUNTS_PER_REV 627.2
+#define VELOCITY_PER_RPM 39.2
+
+// the drive train, WHEEL_RADIUS and BOT_RADIUS in main.hpp
+#define INCHES 0.0254
+#define WHEEL_RADIUS (2.0 * INCHES)
+#define BOT_RADIUS (7.5 * INCHES)
+#define ROBOT_MASS 6.0 // kg
+
+// digital pin the lift's limit switch is on, LIFT_LIMIT in sensors.cpp
+#define LIFT_LIMIT 2
+// how close to the bottom the lift has to be to press the limit switch
+#define LIFT_LIMIT_TRAVEL 0.02 // rad
+
+enum MechanismID
+{
+    LEFT,
+    RIGHT,
+    LIFT,
+    MGL,
+    CLAW,
+    TWISTY_BOI,
+    MECHANISM_COUNT
+};
+
+struct Mechanism
+{
+    // kg*m^2 as seen from the motor shaft
+    double inertia;
+    // torque pulling it back towards its minimum, in N*m
+    double gravity;
+    // torque it takes to get it moving, in N*m
+    double friction;
+    // hard stops, in rad (min >= max means it spins freely)
+    double min;
+    double max;
+    double position;
+    double velocity;
+};
+
+// what a motor port is plugged into
+struct Wiring
+{
+    MechanismID mechanism;
+    // -1 if the motor turns the mechanism backwards for a positive speed
+    int direction;
+    // how many motors are on the port (y-cables)
+    int motors;
+};
+
+// what an IME is attached to, in daisy chain order
+struct Encoder
+{
+    MechanismID mechanism;
+    int direction;
+};
+
+// ports 1 through 10, see the defines at the top of src/motors.cpp
+static const Wiring wiring[SIM_PORT_COUNT] =
+{
+    {TWISTY_BOI, 1, 1},
+    {MGL, 1, 1},
+    {LEFT, 1, 2},
+    {LIFT, -1, 1},
+    {LIFT, -1, 1},
+    {LIFT, 1, 1},
+    {LIFT, 1, 1},
+    {RIGHT, -1, 2},
+    {MGL, -1, 1},
+    {CLAW, 1, 1}
+};
+
+// IME_RIGHT, IME_LEFT, IME_MGL, IME_LIFT
+static const Encoder encoders[] =
+{
+    {RIGHT, -1},
+    {LEFT, 1},
+    {MGL, -1},
+    {LIFT, -1}
+};
+#define ENCODER_COUNT (sizeof(encoders) / sizeof(encoders[0]))
+
+static sim::Config config;
+static Mechanism mechanisms[MECHANISM_COUNT];
+static int motors[SIM_PORT_COUNT];
+static bool pins[SIM_PIN_COUNT];
+static double encoderZeros[ENCODER_COUNT];
+// the robot's real pose, in meters and radians
+static double x;
+static double y;
+static double heading;
+// current pulled by the motors during the last step
+static double current;
+// xorshift state for the IME noise
+static unsigned long long noise;
+
+static void setMechanism(MechanismID id, double inertia, double gravity,
+    double friction, double min, double max)
+{
+    Mechanism& mechanism = mechanisms[id];
+    mechanism.inertia = inertia;
+    mechanism.gravity = gravity;
+    mechanism.friction = friction;
+    mechanism.min = min;
+    mechanism.max = max;
+    mechanism.position = 0;
+    mechanism.velocity = 0;
+}
+
+// a uniformly distributed number in (0, 1]
+static double uniform()
+{
+    noise ^= noise >> 12;
+    noise ^= noise << 25;
+    noise ^= noise >> 27;
+    return ((noise * 2685821657736338717ull) >> 11) / 9007199254740992.0 +
+        1 / 9007199254740992.0;
+}
+
+// a normally distributed number with a standard deviation of 1
+static double gaussian()
+{
+    return sqrt(-2 * log(uniform())) * cos(2 * M_PI * uniform());
+}
+
+// moves a mechanism forward one step with a certain motor torque on it
+static void move(Mechanism& mechanism, double torque, double dt)
+{
+    double velocity = mechanism.velocity;
+    torque -= mechanism.gravity;
+    if (velocity == 0 && fabs(torque) <= mechanism.friction)
+    {
+        // not enough to get it moving
+        return;
+    }
+    double direction = velocity != 0 ? (velocity > 0 ? 1 : -1) :
+        (torque > 0 ? 1 : -1);
+    double next = velocity +
+        (torque - mechanism.friction * direction) / mechanism.inertia * dt;
+    if (velocity != 0 && (next > 0) != (velocity > 0) &&
+        fabs(torque) <= mechanism.friction)
+    {
+        // friction stopped it
+        next = 0;
+    }
+    mechanism.velocity = next;
+    mechanism.position += next * dt;
+    if (mechanism.min < mechanism.max)
+    {
+        if (mechanism.position < mechanism.min)
+        {
+            mechanism.position = mechanism.min;
+            mechanism.velocity = 0;
+        }
+        else if (mechanism.position > mechanism.max)
+        {
+            mechanism.position = mechanism.max;
+            mechanism.velocity = 0;
+        }
+    }
+}
+
+// declared in sim.hpp
+
+void sim::initWorld(const Config& newConfig)
+{
+    config = newConfig;
+    // each side of the drive train has to move half of the robot
+    double driveInertia = ROBOT_MASS / 2 * WHEEL_RADIUS * WHEEL_RADIUS;
+    setMechanism(LEFT, driveInertia, 0, 0.15, 0, 0);
+    setMechanism(RIGHT, driveInertia, 0, 0.15, 0, 0);
+    // LIFT_MAX_REVS is 4.4, the hard stop is a bit past that
+    setMechanism(LIFT, 0.02, 0.8, 0.15, 0, 4.6 * 2 * M_PI);
+    // MGL_MAX_REVS is 3
+    setMechanism(MGL, 0.01, 0.3, 0.1, 0, 3.2 * 2 * M_PI);
+    setMechanism(CLAW, 0.002, 0, 0.1, 0, 0.5 * 2 * M_PI);
+    setMechanism(TWISTY_BOI, 0.002, 0, 0.1, 0, 0.5 * 2 * M_PI);
+    for (unsigned int i = 0; i < SIM_PORT_COUNT; ++i)
+    {
+        motors[i] = 0;
+    }
+    for (unsigned int i = 0; i < SIM_PIN_COUNT; ++i)
+    {
+        // inputs are pulled up
+        pins[i] = true;
+    }
+    for (unsigned int i = 0; i < ENCODER_COUNT; ++i)
+    {
+        encoderZeros[i] = 0;
+    }
+    x = 0;
+    y = 0;
+    heading = 0;
+    current = 0;
+    noise = config.seed * 2654435761ull + 1;
+}
+
+void sim::step()
+{
+    double dt = SIM_STEP / 1000000.0;
+    double voltage = config.battery - BATTERY_RESISTANCE * current;
+    double torques[MECHANISM_COUNT] = {0};
+    current = 0;
+    for (unsigned int i = 0; i < SIM_PORT_COUNT; ++i)
+    {
+        if (motors[i] == 0)
+        {
+            // the motor controller just lets it coast
+            continue;
+        }
+        const Wiring& wire = wiring[i];
+        // how hard the motor is being driven compared to how fast it's
+        //  already going
+        double drive = motors[i] / 127.0 * voltage / NOMINAL_VOLTAGE -
+            wire.direction * mechanisms[wire.mechanism].velocity / FREE_SPEED;
+        torques[wire.mechanism] += wire.direction * wire.motors *
+            config.strength[i] * STALL_TORQUE * drive;
+        current += wire.motors * STALL_CURRENT * fabs(drive);
+    }
+    for (unsigned int i = 0; i < MECHANISM_COUNT; ++i)
+    {
+        move(mechanisms[i], torques[i], dt);
+    }
+    // the wheels don't move the robot as far as they turn when they slip
+    double left = mechanisms[LEFT].velocity * WHEEL_RADIUS *
+        (1 - config.slipLeft);
+    double right = mechanisms[RIGHT].velocity * WHEEL_RADIUS *
+        (1 - config.slipRight);
+    double turn = (right - left) / (2 * BOT_RADIUS) * dt;
+    double middle = heading + turn / 2;
+    x += (left + right) / 2 * cos(middle) * dt;
+    y += (left + right) / 2 * sin(middle) * dt;
+    heading += turn;
+    pins[LIFT_LIMIT - 1] = mechanisms[LIFT].position > LIFT_LIMIT_TRAVEL;
+    checkInterrupts();
+}
+
+void sim::setMotor(unsigned char port, int speed)
+{
+    if (port < 1 || port > SIM_PORT_COUNT)
+    {
+        return;
+    }
+    if (speed > 127)
+    {
+        speed = 127;
+    }
+    else if (speed < -127)
+    {
+        speed = -127;
+    }
+    motors[port - 1] = speed;
+}
+
+int sim::getMotor(unsigned char port)
+{
+    if (port < 1 || port > SIM_PORT_COUNT)
+    {
+        return 0;
+    }
+    return motors[port - 1];
+}
+
+bool sim::readPin(unsigned char pin)
+{
+    if (pin < 1 || pin > SIM_PIN_COUNT)
+    {
+        return false;
+    }
+    return pins[pin - 1];
+}
+
+void sim::writePin(unsigned char pin, bool value)
+{
+    if (pin >= 1 && pin <= SIM_PIN_COUNT && pin != LIFT_LIMIT)
+    {
+        pins[pin - 1] = value;
+    }
+}
+
+unsigned int sim::getImeCount()
+{
+    return ENCODER_COUNT;
+}
+
+bool sim::readIme(unsigned char address, int* counts, int* velocity)
+{
+    if (address >= ENCODER_COUNT)
+    {
+        return false;
+    }
+    const Encoder& encoder = encoders[address];
+    const Mechanism& mechanism = mechanisms[encoder.mechanism];
+    if (counts != NULL)
+    {
+        double exact = encoder.direction * mechanism.position *
+            COUNTS_PER_REV / (2 * M_PI) - encoderZeros[address];
+        *counts = (int) floor(exact + config.imeNoise * gaussian() + 0.5);
+    }
+    if (velocity != NULL)
+    {
+        *velocity = (int) (encoder.direction * mechanism.velocity * 60 /
+            (2 * M_PI) * VELOCITY_PER_RPM);
+    }
+    return true;
+}
+
+bool sim::resetIme(unsigned char address)
+{
+    if (address >= ENCODER_COUNT)
+    {
+        return false;
+    }
+    const Encoder& encoder = encoders[address];
+    encoderZeros[address] = encoder.direction *
+        mechanisms[encoder.mechanism].position * COUNTS_PER_REV / (2 * M_PI);
+    return true;
+}
+
+unsigned int sim::getBatteryLevel()
+{
+    return (unsigned int) ((config.battery - BATTERY_RESISTANCE * current) *
+        1000);
+}
+
+double sim::getGyroHeading()
+{
+    return config.gyro ? heading * 180 / M_PI : 0;
+}
+
+void sim::getTruePose(double& trueX, double& trueY, double& trueHeading)
+{
+    trueX = x / INCHES;
+    trueY = y / INCHES;
+    trueHeading = heading * 180 / M_PI;
+}
@@ -0,0 +1,1231 @@
+// defines the actions that autonomous is made out of, which can run at the
+//  same time as each other
+// the executor steps every running action in the CONTROL phase, right after
+//  the sensors are read and right before the motors are written, and the
+//  autonomous task only starts them and waits on them
+
+#include "main.hpp"
+
+// angles are in degrees, distances are in 1/16 inches
+// not in parentheses to take advantage of only doing integer arithmetic
+#define MOTOR_SPEED 5ul/3ul // rot/s
+#define CLAW_TIME 150ul // ms
+#define MGL_SPEED 63
+
+// how long each action is allowed to take before giving up, in ms
+#define CLAW_BUDGET (2 * CLAW_TIME)
+// the lift and mgl get however long it takes to go the distance at a bit
+//  under how fast they go (position units per second), plus a margin for
+//  speeding up and settling
+#define LIFT_RATE 30.0
+#define LIFT_BUDGET_MARGIN 1000ul
+#define MGL_RATE 20.0 // at MGL_SPEED
+#define MGL_BUDGET_MARGIN 500ul
+// extra time drive actions get on top of how long their profile takes
+#define DT_BUDGET_MARGIN 1000ul
+// how long something has to be moving slower than its minimum speed while
+//  it's being driven to count as stalled, in ms
+#define STALL_TIME 300ul
+// minimum speeds, in 1/16 inches per second and position units per second
+#define DT_STALL_SPEED 20.0
+#define LIFT_STALL_SPEED 3.0
+#define MGL_STALL_SPEED 3.0
+// stalls are only looked for while the drive train is being told to go at
+//  least this fast, so not while a profile is starting or ending
+#define DT_PUSH_SPEED (2 * DT_STALL_SPEED)
+// or while the lift is this close to its target, where the lift controller
+//  eases off
+#define LIFT_PUSH_DISTANCE 8.0
+// how long the autonomous period is, in ms, endRoutine() gives up waiting on
+//  anything still running once it's over
+#define AUTON_PERIOD 15000ul
+// amount of waits that get recorded for the report
+#define WAIT_LOG_SIZE 32
+// amount of drives whose drift gets recorded for the report
+#define DRIFT_LOG_SIZE 16
+
+// drive train motion profile limits, in 1/16 inches per second^n
+// the cruise speed is a bit over what full power really gets (320, see DT_KV)
+//  and just under free speed (2*pi*WHEEL_RADIUS*MOTOR_SPEED, 335), so the
+//  middle of a move is flat out like the old timed drives were and the
+//  position feedback brings it in at the end
+// the drive train can speed up and stop a lot harder than this, it's the
+//  slew rate that limits it, so the jerk phases are only about a tick long
+#define DT_MAX_VELOCITY 330.0
+#define DT_MAX_ACCEL 4000.0
+#define DT_MAX_JERK 200000.0
+// profile follower gains, in motor power per 1/16 inch (per second^n), DT_KV
+//  is full power at the speed the loaded drive train gets to at 7.2V
+// not in parentheses to take advantage of only doing integer arithmetic
+#define DT_KV 127 / 320
+#define DT_KA 1 / 50
+#define DT_KP 18
+#define DT_KD 1 / 20
+// heading hold gains, in motor power per 1/16 inch (per second) that each
+//  wheel would have to go to fix the heading
+#define DT_KH 4
+#define DT_KHD 1 / 5
+// how close the robot has to be to the end of the profile to be done
+#define DT_TOLERANCE units::toCounts(units::Sixteenths(8))
+// how long to keep trying to get in tolerance after the profile ends (ms)
+#define DT_SETTLE_TIMEOUT 500ul
+
+// turns are steered by the heading, and everything's worked out for the
+//  outside wheel in 1/16 inches per second^n
+// turns keep their own limits, they only look at the heading every tick so
+//  they can't brake as hard as a straight drive
+// how fast the outside wheel goes at full power, and how fast it slows down
+//  going into the target heading
+#define TURN_MAX_VELOCITY 300.0
+#define TURN_DECEL 600.0
+// power per 1/16 inch per second that the outside wheel is off by
+#define TURN_KP 0.3
+// how close the heading has to be (degrees) and how slow it has to be
+//  turning (degrees per second) to be done
+#define TURN_TOLERANCE 1.0
+#define TURN_SETTLE_RATE 10.0
+// how long to keep trying to settle after the turn should've been done (ms)
+#define TURN_SETTLE_TIMEOUT 500ul
+
+// following a path is all integer math in the path's units (1/16 inches
+//  and 1/16 inches per second)
+// pure pursuit steers towards a point that's further ahead the faster the
+//  robot's going, in 1/16 inches and ms of driving
+#define PATH_MIN_LOOKAHEAD 96
+#define PATH_MAX_LOOKAHEAD 256
+#define PATH_LOOKAHEAD_TIME 400
+// slowest the robot goes so it doesn't stop short of the end of a path
+#define PATH_MIN_SPEED 40
+// power per 1/16 inch per second that a wheel is going (DT_KV), and that
+//  it's off by
+// not in parentheses to take advantage of only doing integer arithmetic
+#define PATH_KV 127 / 335
+#define PATH_KP 3 / 10
+// how close the robot has to get to the end of a path to be done
+#define PATH_TOLERANCE 16
+// how many points past the last nearest one to look for the nearest one in
+#define PATH_SEARCH 16u
+// extra time following a path gets on top of how long it should take (ms)
+#define PATH_SETTLE_TIMEOUT 1000ul
+
+// distance traveled by one rotation of a wheel, only used for velocities
+//  since positions are measured in counts
+static const double circumference = 2.0 * WHEEL_RADIUS * M_PI;
+
+// how far off the line each drive ended up, DriveAction fills these in
+static auton::DriftRecord driftLog[DRIFT_LOG_SIZE];
+static unsigned int driftCount;
+
+// anything that moves the drive train
+class DriveTrainAction: public auton::Action
+{
+public:
+    DriveTrainAction(): pushing(0) {}
+
+    virtual double getSpeed() const
+    {
+        return circumference * (fabs(motor::getLeftVelocity()) +
+            fabs(motor::getRightVelocity())) / 2;
+    }
+
+    virtual double getStallSpeed() const
+    {
+        return pushing >= DT_PUSH_SPEED ? DT_STALL_SPEED : 0;
+    }
+
+protected:
+    // how fast the drive train is being told to go right now, in 1/16 inches
+    //  per second, which step() keeps up to date
+    // it's a long so a wait() can read it while the executor changes it
+    volatile long pushing;
+
+    // how fast the drive train is turning counterclockwise, in rad/s
+    static double getTurnRate()
+    {
+        return circumference * (motor::getRightVelocity() -
+            motor::getLeftVelocity()) / (2 * BOT_RADIUS);
+    }
+
+    static double toRadians(long heading)
+    {
+        return (double) heading * 2 * M_PI / HEADING_PER_REV;
+    }
+
+    static int clamp(double power)
+    {
+        if (power > 127)
+        {
+            return 127;
+        }
+        if (power < -127)
+        {
+            return -127;
+        }
+        return (int) power;
+    }
+
+    static int clamp(long power)
+    {
+        if (power > 127)
+        {
+            return 127;
+        }
+        if (power < -127)
+        {
+            return -127;
+        }
+        return (int) power;
+    }
+};
+
+// drives each side of the drive train along the same profile, scaled by
+//  leftScale/rightScale
+class DriveAction: public DriveTrainAction
+{
+public:
+    void setup(double distance, int power)
+    {
+        // power now just limits how fast the profile goes
+        profile::Limits limits =
+        {
+            DT_MAX_VELOCITY * abs(power) / 127, DT_MAX_ACCEL, DT_MAX_JERK
+        };
+        if (power < 0)
+        {
+            distance = -distance;
+        }
+        // the profile and where the robot should end up only get worked out
+        //  once per move
+        plan.plan(distance, limits);
+        target = units::toCounts(units::Sixteenths((long) distance));
+    }
+
+protected:
+    virtual void begin()
+    {
+        // measure from where the wheels are now instead of resetting the IMEs
+        leftStart = motor::getLeftCounts();
+        rightStart = motor::getRightCounts();
+        start = odom::getPose();
+        unsigned long angle = (unsigned long) (start.heading >>
+            (HEADING_SHIFT - 16));
+        startCos = odom::sin16(angle + 0x4000);
+        startSin = odom::sin16(angle);
+        maxDrift = 0;
+        pushing = 0;
+    }
+
+    // all integer math, in 1/16 inches (per second^n) and motor power
+    virtual bool step(unsigned long elapsed)
+    {
+        profile::Setpoint setpoint = plan.at(elapsed);
+        pushing = labs(setpoint.velocity);
+        units::Counts left = motor::getLeftCounts() - leftStart;
+        units::Counts right = motor::getRightCounts() - rightStart;
+        long leftSpeed = motor::getLeftSpeed();
+        long rightSpeed = motor::getRightSpeed();
+        odom::Pose pose = odom::getPose();
+        // the average of the two sides follows the profile...
+        long gone = units::toSixteenths(left + right).get() / 2;
+        long forward = setpoint.velocity * DT_KV +
+            setpoint.acceleration * DT_KA +
+            (setpoint.position - gone) * DT_KP +
+            (setpoint.velocity - (leftSpeed + rightSpeed) / 2) * DT_KD;
+        // ...and the difference between them holds the heading it started
+        //  at, worked out as how far each wheel has to go to fix it
+        long trim = getArc(start.heading - pose.heading) * DT_KH -
+            (rightSpeed - leftSpeed) / 2 * DT_KHD;
+        // if a side would go over full power, both sides give some up so the
+        //  trim still happens
+        long excess = labs(forward) + labs(trim) - 127;
+        if (excess > 0)
+        {
+            forward += forward > 0 ? -excess : excess;
+        }
+        motor::setLeftDriveTrain(clamp(forward - trim));
+        motor::setRightDriveTrain(clamp(forward + trim));
+        long drift = labs(getDrift(pose));
+        if (drift > maxDrift)
+        {
+            maxDrift = drift;
+        }
+        if (elapsed < plan.getDuration())
+        {
+            return false;
+        }
+        bool done = units::abs(target - (left + right) / 2) <= DT_TOLERANCE;
+        return done || elapsed >= plan.getDuration() + DT_SETTLE_TIMEOUT;
+    }
+
+    virtual void end()
+    {
+        if (driftCount < DRIFT_LOG_SIZE)
+        {
+            odom::Pose pose = odom::getPose();
+            auton::DriftRecord& record = driftLog[driftCount];
+            record.distance = (long) (((long long) odom::toSixteenths(pose.x -
+                start.x) * startCos + (long long) odom::toSixteenths(pose.y -
+                start.y) * startSin) >> 14);
+            record.drift = getDrift(pose);
+            record.maxDrift = maxDrift;
+            record.headingError = toRadians(pose.heading - start.heading) *
+                180 / M_PI;
+        }
+        ++driftCount;
+    }
+
+    virtual unsigned long getBudget() const
+    {
+        return plan.getDuration() + DT_SETTLE_TIMEOUT + DT_BUDGET_MARGIN;
+    }
+
+private:
+    // how far to the left of the line it started on the robot is, in 1/16
+    //  inches
+    long getDrift(const odom::Pose& pose) const
+    {
+        return (long) (((long long) odom::toSixteenths(pose.y - start.y) *
+            startCos - (long long) odom::toSixteenths(pose.x - start.x) *
+            startSin) >> 14);
+    }
+
+    // how far a wheel has to go to turn the robot by a change in heading, in
+    //  1/16 inches
+    static long getArc(long heading)
+    {
+        static const long long factor = units::factor(2 * M_PI * BOT_RADIUS /
+            65536);
+        return units::scale(heading >> (HEADING_SHIFT - 16), factor);
+    }
+
+    profile::Profile plan;
+    // how far the average of the two sides should go
+    units::Counts target;
+    units::Counts leftStart;
+    units::Counts rightStart;
+    odom::Pose start;
+    // cos and sin of the starting heading << 14
+    long startCos;
+    long startSin;
+    long maxDrift;
+};
+
+// turns to a heading, going around an arc with the outside wheel at
+//  outerRadius and the other side scaled by leftScale/rightScale
+// the heading comes from the odometry, which follows the gyro if there is
+//  one, and the turn slows down so it stops right on the heading instead of
+//  guessing when it's gone far enough
+class TurnAction: public DriveTrainAction
+{
+public:
+    // angle is in degrees and direction is 1 if the heading should go up
+    //  (counterclockwise) or -1 if it should go down
+    void setup(double angle, int direction, double outerRadius, int power,
+        double leftScale, double rightScale)
+    {
+        this->direction = direction;
+        this->outerRadius = outerRadius;
+        this->leftScale = power < 0 ? -leftScale : leftScale;
+        this->rightScale = power < 0 ? -rightScale : rightScale;
+        distance = angle * M_PI / 180 * outerRadius;
+        maxSpeed = TURN_MAX_VELOCITY * abs(power) / 127;
+        // speeding up and slowing down each take about maxSpeed/TURN_DECEL
+        duration = (unsigned long) (1000 * (distance / maxSpeed +
+            maxSpeed / TURN_DECEL));
+    }
+
+protected:
+    virtual void begin()
+    {
+        startHeading = odom::getPose().heading;
+        pushing = 0;
+    }
+
+    virtual bool step(unsigned long elapsed)
+    {
+        long turned = (odom::getPose().heading - startHeading) * direction;
+        // in 1/16 inches of the outside wheel, so they're comparable with
+        //  the drive train limits
+        double left = distance - toRadians(turned) * outerRadius;
+        double speed = getTurnRate() * direction * outerRadius;
+        // fast enough to still stop in time
+        double target = sqrt(2 * TURN_DECEL * fabs(left));
+        if (target > maxSpeed)
+        {
+            target = maxSpeed;
+        }
+        pushing = (long) target;
+        if (left < 0)
+        {
+            target = -target;
+        }
+        double power = target * DT_KV + TURN_KP * (target - speed);
+        motor::setLeftDriveTrain(clamp(power * leftScale));
+        motor::setRightDriveTrain(clamp(power * rightScale));
+        bool done = fabs(left) <= TURN_TOLERANCE * M_PI / 180 * outerRadius &&
+            fabs(speed) <= TURN_SETTLE_RATE * M_PI / 180 * outerRadius;
+        return done || elapsed >= duration + TURN_SETTLE_TIMEOUT;
+    }
+
+    virtual unsigned long getBudget() const
+    {
+        return duration + TURN_SETTLE_TIMEOUT + DT_BUDGET_MARGIN;
+    }
+
+private:
+    int direction;
+    double outerRadius;
+    double leftScale;
+    double rightScale;
+    // how far the outside wheel has to go, in 1/16 inches
+    double distance;
+    double maxSpeed;
+    // about how long the turn should take in ms
+    unsigned long duration;
+    long startHeading;
+};
+
+// drives along a path from tools/paths.txt with pure pursuit, steering
+//  towards the point on the path one lookahead ahead of the nearest one
+// the path already has how fast to go at each point worked out, so all that
+//  happens every tick is finding the nearest point and the lookahead point
+//  and working out the curvature to get there
+class FollowAction: public DriveTrainAction
+{
+public:
+    // the path can be mirrored (y is flipped) for the other side of the field
+    // it has to have at least 2 points
+    void setup(const path::Path& path, int power, bool mirror)
+    {
+        this->path = &path;
+        this->power = abs(power);
+        backwards = power < 0;
+        this->mirror = mirror ? -1 : 1;
+        // about how long it should take going the speeds on the path
+        duration = 0;
+        for (unsigned int i = 1; i < path.size; ++i)
+        {
+            duration += 1000 * PATH_SPACING / getTargetSpeed(i);
+        }
+    }
+
+protected:
+    virtual void begin()
+    {
+        nearest = 0;
+        speed = 0;
+        lastTime = 0;
+        pushing = 0;
+    }
+
+    virtual bool step(unsigned long elapsed)
+    {
+        odom::Pose pose = odom::getPose();
+        long x = odom::toSixteenths(pose.x);
+        long y = odom::toSixteenths(pose.y);
+        // going backwards is going forwards with the back of the robot
+        unsigned long angle = (unsigned long) (pose.heading >>
+            (HEADING_SHIFT - 16)) + (backwards ? 0x8000 : 0);
+        long cosine = odom::sin16(angle + 0x4000);
+        long sine = odom::sin16(angle);
+        findNearest(x, y);
+        const path::Point& end = path->points[path->size - 1];
+        long endX = end.x - x;
+        long endY = end.y * mirror - y;
+        // done once it's close to the end or the end is behind it
+        if (squared(endX, endY) <= PATH_TOLERANCE * PATH_TOLERANCE ||
+            (nearest + 1 >= path->size &&
+            (long long) endX * cosine + (long long) endY * sine <= 0))
+        {
+            return true;
+        }
+        // speed up towards the speed on the path without going over the
+        //  drive train's acceleration
+        long target = getTargetSpeed(nearest);
+        long change = PATH_MAX_ACCEL * (long) (elapsed - lastTime) / 1000;
+        lastTime = elapsed;
+        speed = target > speed + change ? speed + change : target;
+        pushing = speed;
+        long leftSpeed = motor::getLeftSpeed();
+        long rightSpeed = motor::getRightSpeed();
+        // the lookahead point is the first point far enough away
+        long lookahead = labs(leftSpeed + rightSpeed) / 2 *
+            PATH_LOOKAHEAD_TIME / 1000;
+        if (lookahead < PATH_MIN_LOOKAHEAD)
+        {
+            lookahead = PATH_MIN_LOOKAHEAD;
+        }
+        else if (lookahead > PATH_MAX_LOOKAHEAD)
+        {
+            lookahead = PATH_MAX_LOOKAHEAD;
+        }
+        unsigned int ahead = nearest;
+        long dx;
+        long dy;
+        do
+        {
+            dx = path->points[ahead].x - x;
+            dy = path->points[ahead].y * mirror - y;
+        }
+        while (squared(dx, dy) < lookahead * lookahead &&
+            ++ahead < path->size);
+        if (ahead >= path->size)
+        {
+            extendPastEnd(dx, dy, lookahead);
+        }
+        // curvature of the arc that goes from the robot to the lookahead
+        //  point is 2 * how far it is to the side / distance^2, and each
+        //  wheel goes that times BOT_RADIUS faster or slower
+        long side = (long) (((long long) dy * cosine -
+            (long long) dx * sine) >> 14);
+        long long distance = squared(dx, dy);
+        long turn = distance > 0 ? (long) ((long long) speed * 2 * side *
+            (long) BOT_RADIUS / distance) : 0;
+        long left = speed - turn;
+        long right = speed + turn;
+        if (backwards)
+        {
+            // the robot's left is the backwards robot's right
+            long swap = left;
+            left = -right;
+            right = -swap;
+        }
+        motor::setLeftDriveTrain(clamp(left * PATH_KV +
+            (left - leftSpeed) * PATH_KP));
+        motor::setRightDriveTrain(clamp(right * PATH_KV +
+            (right - rightSpeed) * PATH_KP));
+        return elapsed >= duration + PATH_SETTLE_TIMEOUT;
+    }
+
+    virtual unsigned long getBudget() const
+    {
+        return duration + PATH_SETTLE_TIMEOUT + DT_BUDGET_MARGIN;
+    }
+
+private:
+    static long long squared(long dx, long dy)
+    {
+        return (long long) dx * dx + (long long) dy * dy;
+    }
+
+    static long squareRoot(long long value)
+    {
+        // one bit at a time, from the highest one that could be set
+        long long root = 0;
+        long long bit = 1ll << 62;
+        while (bit > value)
+        {
+            bit >>= 2;
+        }
+        while (bit != 0)
+        {
+            if (value >= root + bit)
+            {
+                value -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else
+            {
+                root >>= 1;
+            }
+            bit >>= 2;
+        }
+        return (long) root;
+    }
+
+    // how fast the path says to go at a point, scaled by the power
+    long getTargetSpeed(unsigned int index) const
+    {
+        long target = path->points[index].speed * power / 127;
+        return target > PATH_MIN_SPEED ? target : PATH_MIN_SPEED;
+    }
+
+    // moves nearest to the closest point to the robot, only looking a bit
+    //  past where it was since the robot doesn't go backwards along the path
+    void findNearest(long x, long y)
+    {
+        unsigned int last = nearest + PATH_SEARCH;
+        if (last > path->size)
+        {
+            last = path->size;
+        }
+        long long closest = -1;
+        for (unsigned int i = nearest; i < last; ++i)
+        {
+            long long distance = squared(path->points[i].x - x,
+                path->points[i].y * mirror - y);
+            if (closest < 0 || distance < closest)
+            {
+                closest = distance;
+                nearest = i;
+            }
+        }
+    }
+
+    // the end of the path is closer than the lookahead (dx, dy), so this
+    //  keeps going the way the last bit of the path goes until it's a
+    //  lookahead away, so the robot ends up pointed that way instead of
+    //  cutting towards the end
+    void extendPastEnd(long& dx, long& dy, long lookahead) const
+    {
+        const path::Point& end = path->points[path->size - 1];
+        const path::Point& before = path->points[path->size - 2];
+        long ux = end.x - before.x;
+        long uy = (end.y - before.y) * mirror;
+        long length = squareRoot(squared(ux, uy));
+        if (length == 0)
+        {
+            return;
+        }
+        // how far along the last bit the end is from the robot, and how
+        //  much further the point a lookahead away is
+        long along = (long) (((long long) dx * ux + (long long) dy * uy) /
+            length);
+        long extra = -along + squareRoot((long long) along * along -
+            squared(dx, dy) + (long long) lookahead * lookahead);
+        dx += ux * extra / length;
+        dy += uy * extra / length;
+    }
+
+    const path::Path* path;
+    // how much of the speeds on the path to go, out of 127
+    int power;
+    bool backwards;
+    // -1 if the path is mirrored, or 1
+    int mirror;
+    // about how long the path should take in ms
+    unsigned long duration;
+    unsigned int nearest;
+    // speed the robot is being told to go, and when it was last changed
+    long speed;
+    unsigned long lastTime;
+};
+
+// hands the lift over to the lift controller and waits for it to settle
+class LiftAction: public auton::Action
+{
+public:
+    void setup(double target)
+    {
+        this->target = target;
+    }
+
+protected:
+    virtual void begin()
+    {
+        budget = (unsigned long) (1000 * fabs(target - motor::getLiftPos()) /
+            LIFT_RATE) + LIFT_BUDGET_MARGIN;
+        motor::setLiftTarget(target);
+    }
+
+    virtual bool step(unsigned long)
+    {
+        // the lift controller keeps holding the lift there after this is done
+        return motor::isLiftSettled();
+    }
+
+    virtual unsigned long getBudget() const
+    {
+        return budget;
+    }
+
+    virtual double getSpeed() const
+    {
+        return fabs(motor::getLiftVelocity());
+    }
+
+    virtual double getStallSpeed() const
+    {
+        // it's supposed to slow down once it's close
+        if (fabs(target - motor::getLiftPos()) <= LIFT_PUSH_DISTANCE)
+        {
+            return 0;
+        }
+        return LIFT_STALL_SPEED;
+    }
+
+private:
+    double target;
+    unsigned long budget;
+};
+
+// runs the claw for CLAW_TIME
+class ClawAction: public auton::Action
+{
+public:
+    void setup(motor::Direction direction)
+    {
+        this->direction = direction;
+    }
+
+protected:
+    virtual void begin()
+    {
+        motor::setClaw(direction);
+    }
+
+    virtual bool step(unsigned long elapsed)
+    {
+        return elapsed >= CLAW_TIME;
+    }
+
+    virtual void end()
+    {
+        motor::setClaw(motor::STOP);
+    }
+
+    virtual unsigned long getBudget() const
+    {
+        return CLAW_BUDGET;
+    }
+
+private:
+    motor::Direction direction;
+};
+
+// drives the mobile goal lift until it passes the target
+class MglAction: public auton::Action
+{
+public:
+    void setup(double target)
+    {
+        this->target = target;
+    }
+
+protected:
+    virtual void begin()
+    {
+        double pos = motor::getMglPos();
+        up = target > pos;
+        budget = (unsigned long) (1000 * fabs(target - pos) / MGL_RATE) +
+            MGL_BUDGET_MARGIN;
+    }
+
+    virtual bool step(unsigned long)
+    {
+        double pos = motor::getMglPos();
+        if (up ? pos >= target : pos <= target)
+        {
+            return true;
+        }
+        motor::setMgl(up ? MGL_SPEED : -MGL_SPEED);
+        return false;
+    }
+
+    virtual void end()
+    {
+        motor::setMgl(0);
+    }
+
+    virtual unsigned long getBudget() const
+    {
+        return budget;
+    }
+
+    virtual double getSpeed() const
+    {
+        return fabs(motor::getMglVelocity());
+    }
+
+    virtual double getStallSpeed() const
+    {
+        return MGL_STALL_SPEED;
+    }
+
+private:
+    double target;
+    bool up;
+    unsigned long budget;
+};
+
+// there's only one of each action since each one uses a different part of
+//  the robot, so starting one again just restarts it
+// driving, turning and following paths all use the drive train, so starting
+//  one cancels the others
+static DriveAction driveAction;
+static TurnAction turnAction;
+static FollowAction followAction;
+static LiftAction liftAction;
+static ClawAction clawAction;
+static MglAction mglAction;
+static auton::Action* const actions[] =
+{
+    &driveAction, &turnAction, &followAction, &liftAction, &clawAction,
+    &mglAction
+};
+#define ACTION_COUNT (sizeof(actions) / sizeof(actions[0]))
+
+// timing stuff for the report
+static unsigned long routineStart;
+// only control() uses it
+static unsigned long lastTick;
+// total time saved by having more than one action running at once
+static volatile unsigned long overlapTime;
+// how long each wait took compared to its budget
+static auton::WaitRecord waitLog[WAIT_LOG_SIZE];
+static unsigned int waitCount;
+// times every wait() loop, and endRoutine()'s
+static timing::LoopTimer waitTimer("auton", MOTOR_POLL_RATE);
+// given every time the executor has stepped the actions, so waits can check
+//  on them right after
+static Semaphore stepped;
+
+// used to wait on handles
+static bool handleDone(void* handle)
+{
+    return auton::isDone(*(auton::Handle*) handle);
+}
+
+static bool handlesDone(void* handles)
+{
+    auton::Handle* pair = (auton::Handle*) handles;
+    return auton::isDone(pair[0]) && auton::isDone(pair[1]);
+}
+
+// gets how fast the action a handle refers to is going
+static double handleSpeed(void* handle)
+{
+    return ((auton::Handle*) handle)->action->getSpeed();
+}
+
+// gets how slow the action a handle refers to can go right now, or 0 once
+//  it's done since join() keeps watching it while the other one finishes
+static double handleStallSpeed(void* handle)
+{
+    auton::Handle* watched = (auton::Handle*) handle;
+    if (auton::isDone(*watched))
+    {
+        return 0;
+    }
+    return watched->action->getStallSpeed();
+}
+
+// builds a stall watch for the action a handle refers to
+static auton::StallWatch watch(auton::Handle* handle)
+{
+    auton::StallWatch watch =
+    {
+        handleSpeed, handleStallSpeed, handle, STALL_TIME
+    };
+    return watch;
+}
+
+// stops an action if waiting on it didn't work out
+static auton::WaitResult settle(auton::Handle handle,
+    auton::WaitResult result)
+{
+    if (result != auton::WAIT_DONE && !auton::isDone(handle))
+    {
+        handle.action->cancel();
+    }
+    return result;
+}
+
+// blocks until the executor steps the actions again, or timeout ms pass
+//  in case it's fallen behind
+static void waitForStep(unsigned long timeout)
+{
+    semaphoreTake(stepped, timeout);
+}
+
+// stops everything that uses the drive train
+static void cancelDriveTrain()
+{
+    driveAction.cancel();
+    turnAction.cancel();
+    followAction.cancel();
+}
+
+// starts an action and gets a handle to this run of it
+static auton::Handle launch(auton::Action& action)
+{
+    action.start();
+    auton::Handle handle = { &action, action.getGeneration() };
+    return handle;
+}
+
+// declared in main.hpp
+
+auton::Action::Action(): running(false), generation(0), startTime(0),
+    duration(0)
+{
+}
+
+void auton::Action::start()
+{
+    cancel();
+    ++generation;
+    startTime = millis();
+    begin();
+    // the executor can step it as soon as it's running, so everything else
+    //  has to be set up first
+    __sync_synchronize();
+    running = true;
+}
+
+bool auton::Action::update()
+{
+    if (running && step(millis() - startTime))
+    {
+        finish();
+    }
+    return !running;
+}
+
+void auton::Action::cancel()
+{
+    finish();
+}
+
+bool auton::Action::isRunning() const
+{
+    return running;
+}
+
+unsigned long auton::Action::getGeneration() const
+{
+    return generation;
+}
+
+unsigned long auton::Action::getStartTime() const
+{
+    return startTime;
+}
+
+unsigned long auton::Action::getDuration() const
+{
+    return duration;
+}
+
+void auton::Action::end()
+{
+}
+
+unsigned long auton::Action::getBudget() const
+{
+    return 0;
+}
+
+void auton::Action::finish()
+{
+    // the executor can finish an action while the autonomous task is
+    //  cancelling it, and only one of them should end it
+    if (__sync_bool_compare_and_swap(&running, true, false))
+    {
+        duration = millis() - startTime;
+        end();
+    }
+}
+
+double auton::Action::getSpeed() const
+{
+    return 0;
+}
+
+double auton::Action::getStallSpeed() const
+{
+    return 0;
+}
+
+bool auton::isDone(Handle handle)
+{
+    // if the action was started again, this run of it is over
+    return handle.action == NULL || !handle.action->isRunning() ||
+        handle.action->getGeneration() != handle.generation;
+}
+
+auton::Handle auton::straight(unsigned long distance, int power)
+{
+    cancelDriveTrain();
+    driveAction.setup(distance, power);
+    return launch(driveAction);
+}
+
+auton::Handle auton::turnCW(unsigned int angle, int turnRadius, int leftPower)
+{
+    /*
+     * T=time to make a full circle
+     * leftSpeed*T = 2*pi*(turnRadius+BOT_RADIUS)
+     * rightSpeed*T = 2*pi*(turnRadius-BOT_RADIUS)
+     * T/(2*pi) = (turnRadius+BOT_RADIUS)/leftSpeed =
+     *    (turnRadius-BOT_RADIUS)/rightSpeed
+     * rightSpeed = leftSpeed*(turnRadius-BOT_RADIUS)/(turnRadius+BOT_RADIUS)
+     * speed = (power/127)*(2*pi*WHEEL_RADIUS*MOTOR_SPEED)/(1 rotation)
+     * (motor speed is proportional to motor power)
+     * rightPower = leftPower*(turnRadius-BOT_RADIUS)/(turnRadius+BOT_RADIUS)
+     */
+    double rightScale = ((double) turnRadius - BOT_RADIUS) /
+        ((double) turnRadius + BOT_RADIUS);
+    // going backwards around the arc turns the other way
+    cancelDriveTrain();
+    turnAction.setup(angle, leftPower < 0 ? 1 : -1, turnRadius + BOT_RADIUS,
+        leftPower, 1, rightScale);
+    return launch(turnAction);
+}
+
+auton::Handle auton::turnCCW(unsigned int angle, int turnRadius,
+    int rightPower)
+{
+    // very similar to how turnCW calculates rightScale
+    double leftScale = ((double) turnRadius - BOT_RADIUS) /
+        ((double) turnRadius + BOT_RADIUS);
+    cancelDriveTrain();
+    turnAction.setup(angle, rightPower < 0 ? -1 : 1, turnRadius + BOT_RADIUS,
+        rightPower, leftScale, 1);
+    return launch(turnAction);
+}
+
+auton::Handle auton::follow(unsigned int index, int power, bool mirror)
+{
+    cancelDriveTrain();
+    // following a path takes at least 2 points to know which way it goes
+    if (index >= path::pathCount || path::paths[index].size < 2)
+    {
+        // a handle to a run that's already over
+        auton::Handle handle = { &followAction, followAction.getGeneration() };
+        return handle;
+    }
+    followAction.setup(path::paths[index], power, mirror);
+    return launch(followAction);
+}
+
+auton::Handle auton::follow(const char* name, int power, bool mirror)
+{
+    unsigned int index = 0;
+    while (index < path::pathCount &&
+        strcmp(path::paths[index].name, name) != 0)
+    {
+        ++index;
+    }
+    return follow(index, power, mirror);
+}
+
+void auton::stop()
+{
+    cancelDriveTrain();
+    motor::setLeftDriveTrain(0);
+    motor::setRightDriveTrain(0);
+}
+
+auton::Handle auton::lift(double target)
+{
+    // the executor could be stepping it, so it has to stop before it changes
+    liftAction.cancel();
+    liftAction.setup(target);
+    return launch(liftAction);
+}
+
+auton::Handle auton::claw(motor::Direction direction)
+{
+    clawAction.cancel();
+    clawAction.setup(direction);
+    return launch(clawAction);
+}
+
+auton::Handle auton::mgl(double target)
+{
+    mglAction.cancel();
+    mglAction.setup(target);
+    return launch(mglAction);
+}
+
+auton::WaitResult auton::wait(Predicate done, void* arg,
+    unsigned long budget, const StallWatch* stall)
+{
+    unsigned long start = millis();
+    // when the thing being watched started going too slow, or 0 if it isn't
+    unsigned long slowSince = 0;
+    WaitResult result;
+    waitTimer.enter();
+    while (true)
+    {
+        waitTimer.start();
+        unsigned long now = millis();
+        if (done(arg))
+        {
+            result = WAIT_DONE;
+            break;
+        }
+        if (now - start >= budget)
+        {
+            result = WAIT_TIMEOUT;
+            break;
+        }
+        if (stall != NULL)
+        {
+            double minSpeed = stall->minSpeed(stall->arg);
+            if (minSpeed <= 0 || stall->speed(stall->arg) >= minSpeed)
+            {
+                slowSince = 0;
+            }
+            else if (slowSince == 0)
+            {
+                slowSince = now;
+            }
+            else if (now - slowSince >= stall->time)
+            {
+                result = WAIT_STALLED;
+                break;
+            }
+        }
+        waitTimer.stop();
+        // the executor moves the actions along, this only checks on them
+        waitForStep(2 * MOTOR_POLL_RATE);
+    }
+    // every way out of the loop skips the stop() at the bottom of it
+    waitTimer.stop();
+    if (waitCount < WAIT_LOG_SIZE)
+    {
+        WaitRecord& record = waitLog[waitCount];
+        record.budget = budget;
+        record.took = millis() - start;
+        record.result = result;
+    }
+    ++waitCount;
+    return result;
+}
+
+auton::WaitResult auton::await(Handle handle)
+{
+    StallWatch stall = watch(&handle);
+    return settle(handle, wait(handleDone, &handle,
+        handle.action->getBudget(), &stall));
+}
+
+auton::WaitResult auton::join(Handle a, Handle b)
+{
+    // only watch the first one for stalls
+    Handle pair[2] = { a, b };
+    StallWatch stall = watch(&pair[0]);
+    unsigned long budget = a.action->getBudget();
+    if (b.action->getBudget() > budget)
+    {
+        budget = b.action->getBudget();
+    }
+    WaitResult result = wait(handlesDone, pair, budget, &stall);
+    settle(b, result);
+    return settle(a, result);
+}
+
+bool auton::race(Handle handle, unsigned long timeout)
+{
+    return wait(handleDone, &handle, timeout, NULL) == WAIT_DONE;
+}
+
+void auton::init()
+{
+    stepped = semaphoreCreate();
+}
+
+void auton::control()
+{
+    unsigned long now = exec::getTime();
+    unsigned int running = 0;
+    for (unsigned int i = 0; i < ACTION_COUNT; ++i)
+    {
+        if (actions[i]->isRunning())
+        {
+            ++running;
+            actions[i]->update();
+        }
+    }
+    // if n actions ran since the last tick, doing them one after another
+    //  would've taken n - 1 ticks longer
+    if (running > 1)
+    {
+        overlapTime += (running - 1) * (now - lastTick);
+    }
+    lastTick = now;
+    semaphoreGive(stepped);
+}
+
+void auton::beginRoutine()
+{
+    routineStart = millis();
+    overlapTime = 0;
+    waitCount = 0;
+    driftCount = 0;
+}
+
+void auton::endRoutine(const char* name)
+{
+    // let anything that's still going finish up, but not past its budget or
+    //  the end of the period, since something like a jammed lift might never
+    //  finish
+    unsigned long deadline = routineStart + AUTON_PERIOD;
+    unsigned long latest = 0;
+    bool running = false;
+    for (unsigned int i = 0; i < ACTION_COUNT; ++i)
+    {
+        const Action* action = actions[i];
+        if (action->isRunning())
+        {
+            unsigned long end = action->getStartTime() + action->getBudget();
+            if (!running || (long) (end - latest) > 0)
+            {
+                latest = end;
+            }
+            running = true;
+        }
+    }
+    if (running && (long) (latest - deadline) < 0)
+    {
+        deadline = latest;
+    }
+    waitTimer.enter();
+    while (running && (long) (millis() - deadline) < 0)
+    {
+        waitForStep(2 * MOTOR_POLL_RATE);
+        waitTimer.start();
+        running = false;
+        for (unsigned int i = 0; i < ACTION_COUNT; ++i)
+        {
+            running = running || actions[i]->isRunning();
+        }
+        waitTimer.stop();
+    }
+    unsigned int cancelled = 0;
+    for (unsigned int i = 0; i < ACTION_COUNT; ++i)
+    {
+        if (actions[i]->isRunning())
+        {
+            actions[i]->cancel();
+            ++cancelled;
+        }
+    }
+    if (cancelled > 0)
+    {
+        stop();
+        printf("auton %s: cancelled %u actions that were still running\n",
+            name, cancelled);
+    }
+    unsigned long took = millis() - routineStart;
+    printf("auton %s: took %lu ms, %lu ms if run one at a time (saved %lu ms)\n",
+        name, took, took + overlapTime, overlapTime);
+    static const char* results[] = { "done", "timeout", "stalled" };
+    for (unsigned int i = 0; i < waitCount && i < WAIT_LOG_SIZE; ++i)
+    {
+        printf("  wait %u: %lu/%lu ms, %s\n", i, waitLog[i].took,
+            waitLog[i].budget, results[waitLog[i].result]);
+    }
+    for (unsigned int i = 0; i < driftCount && i < DRIFT_LOG_SIZE; ++i)
+    {
+        const DriftRecord& record = driftLog[i];
+        printf("  drive %u: %ld/16 in, drifted %ld/16 in (max %ld), heading "
+            "off by %.1f deg\n", i, record.distance, record.drift,
+            record.maxDrift, record.headingError);
+    }
+    timing::dump();
+}
+
+const auton::WaitRecord* auton::getWaitLog(unsigned int* count)
+{
+    *count = waitCount < WAIT_LOG_SIZE ? waitCount : WAIT_LOG_SIZE;
+    return waitLog;
+}
+
+const auton::DriftRecord* auton::getDriftLog(unsigned int* count)
+{
+    *count = driftCount < DRIFT_LOG_SIZE ? driftCount : DRIFT_LOG_SIZE;
+    return driftLog;
+}
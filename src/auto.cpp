@@ -2,45 +2,44 @@
 
 #include "main.hpp"
 
-// angles are in degrees, distances are in 1/16 inches
-#define WHEEL_RADIUS 32ul
-#define BOT_RADIUS 120ul
-// not in parentheses to take advantage of only doing integer arithmetic
-#define MOTOR_SPEED 5ul/3ul // rot/s
-#define PI 22ul/7ul // overestimated (22/7>PI) because ints always round down
-#define CLAW_TIME 150ul // ms
-
 // autonomous plans
 static void forwardBackward();
 static void scoreMgWithCone(bool left);
 static void scoreStationary();
 
-// dt functions require a stop() at the end to allow chaining
-static void turnCW(unsigned int angle, int turnRadius, int leftPower);
-static void turnCCW(unsigned int angle, int turnRadius, int rightPower);
-static void straight(unsigned long distance, int power);
-static void stop();
-// other stuff
-static void lift(double target); // max=127, min=0
-static void claw(motor::Direction direction);
-static void mgl(double target);
-
 // main point of execution for the autonomous period
 void autonomous()
 {
+    telemetry::start(TELEMETRY_AUTON_FILE);
+    // paths are from where the robot is now, not where it was turned on
+    odom::Pose start = { 0, 0, 0, 0 };
+    odom::setPose(start);
+    auton::beginRoutine();
     switch (auton::autonid)
     {
     case auton::FORWARD_BACKWARD:
         forwardBackward();
+        auton::endRoutine("forward+backward");
         break;
     case auton::MG_CONE_LEFT:
         scoreMgWithCone(true);
+        auton::endRoutine("mg+cone left");
         break;
     case auton::MG_CONE_RIGHT:
         scoreMgWithCone(false);
+        auton::endRoutine("mg+cone right");
         break;
     case auton::SCORE_STATIONARY:
         scoreStationary();
+        auton::endRoutine("score stationary");
+        break;
+    case auton::REPLAY_DRIVER:
+        input::replay();
+        auton::endRoutine("replay driver");
+        break;
+    case auton::SCRIPT:
+        auton::runScript(auton::scriptid);
+        auton::endRoutine(auton::getScriptName(auton::scriptid));
         break;
     default:
         ; // just do nothing
@@ -49,187 +48,75 @@ void autonomous()
 
 void forwardBackward()
 {
-    straight(100, 95);
-    straight(100, -95);
+    using namespace auton;
+    await(straight(100, 95));
+    await(straight(100, -95));
     stop();
 }
 
 void scoreMgWithCone(bool left)
 {
-    using namespace motor;
+    using namespace auton;
+    using motor::CLOSE;
+    using motor::OPEN;
     // start pointed backwards, with the cone in the mgl part
     // pick up the cone
-    claw(CLOSE);
-    lift(63);
-    // drive over to the mobile goal
-    straight(500, -127);
+    await(claw(CLOSE));
+    // lift the cone while driving over to the mobile goal
+    Handle raise = lift(63);
+    await(straight(500, -127));
     stop();
+    await(raise);
     // put the cone on the mobile goal
-    lift(-31);
-    claw(OPEN);
-    // pick up the mobile goal
-    mgl(63);
-    // drive over to the white tape
-    straight(740, 127);
+    await(lift(-31));
+    await(claw(OPEN));
+    // pick up the mobile goal while driving over to the white tape and
+    //  curving around to line up with the 20pt zone, without stopping at the
+    //  corner. the mgl is watched for stalls, and there's no point in going
+    //  on without it
+    if (join(mgl(63), follow("mgzone", 127, !left)) != WAIT_DONE)
+    {
+        stop();
+        return;
+    }
+    stop();
     // align with the 20pt zone
     if (left)
     {
-        turnCCW(45, 0, 64);
-        straight(512, 127);
-        turnCCW(90, 0, 64);
+        await(turnCCW(90, 0, 64));
     }
     else
     {
-        turnCW(45, 0, 64);
-        straight(512, 127);
-        turnCW(90, 0, 64);
+        await(turnCW(90, 0, 64));
     }
     // score the mobile goal into the 20pt zone
-    straight(530, -127);
+    await(straight(530, -127));
     stop();
-    mgl(0);
+    await(mgl(0));
     // get out of the bumps to give the driver some extra time
-    straight(450, 127);
+    await(straight(450, 127));
     stop();
 }
 
 void scoreStationary()
 {
-    using namespace motor;
+    using namespace auton;
+    using motor::CLOSE;
+    using motor::OPEN;
     // start on the middle
     // pick up the cone
-    claw(CLOSE);
-    lift(126);
+    await(claw(CLOSE));
+    // the lift has to be all the way up before getting to the goal
+    await(lift(126));
     // go up to the stationary goal
-    straight(160, 64);
+    await(straight(160, 64));
     stop();
     // score the preload
-    lift(100);
-    claw(OPEN);
+    await(lift(100));
+    await(claw(OPEN));
     // back up a bit to fully lower the lift
-    straight(64, -64);
+    await(straight(64, -64));
     stop();
-    claw(CLOSE);
-    lift(0);
-}
-
-void turnCW(unsigned int angle, int turnRadius, int leftPower)
-{
-    /*
-     * T=time to make a full circle
-     * leftSpeed*T = 2*pi*(turnRadius+BOT_RADIUS)
-     * rightSpeed*T = 2*pi*(turnRadius-BOT_RADIUS)
-     * T/(2*pi) = (turnRadius+BOT_RADIUS)/leftSpeed =
-     *    (turnRadius-BOT_RADIUS)/rightSpeed
-     * rightSpeed = leftSpeed*(turnRadius-BOT_RADIUS)/(turnRadius+BOT_RADIUS)
-     * speed = (power/127)*(2*pi*WHEEL_RADIUS*MOTOR_SPEED)/(1 rotation)
-     * (motor speed is proportional to motor power)
-     * rightPower = leftPower*(turnRadius-BOT_RADIUS)/(turnRadius+BOT_RADIUS)
-     */
-    int rightPower = (((int) turnRadius - (int) BOT_RADIUS) * leftPower) /
-        ((int) turnRadius + (int) BOT_RADIUS);
-    // calculate the arc outside length
-    unsigned long distance = (turnRadius + BOT_RADIUS) * angle * PI / 180;
-    motor::resetDT();
-    motor::setLeftDriveTrain(leftPower);
-    motor::setRightDriveTrain(rightPower);
-    unsigned long now = millis();
-    while (2.0 * WHEEL_RADIUS * PI * motor::getLeftRotations() < distance)
-    {
-        taskDelayUntil(&now, MOTOR_POLL_RATE);
-    }
-}
-
-void turnCCW(unsigned int angle, int turnRadius, int rightPower)
-{
-    // very similar to how turnCW calculates rightPower
-    int leftPower = (((int) turnRadius - (int) BOT_RADIUS) * rightPower) /
-        ((int) turnRadius + (int) BOT_RADIUS);
-    // calculate the outside arc length
-    unsigned long distance = (turnRadius + BOT_RADIUS) * angle * PI / 180;
-    motor::resetDT();
-    motor::setLeftDriveTrain(leftPower);
-    motor::setRightDriveTrain(rightPower);
-    unsigned long now = millis();
-    while (2.0 * WHEEL_RADIUS * PI * motor::getRightRotations() < distance)
-    {
-        taskDelayUntil(&now, MOTOR_POLL_RATE);
-    }
-}
-
-void straight(unsigned long distance, int power)
-{
-    motor::resetDT();
-    motor::setLeftDriveTrain(power);
-    motor::setRightDriveTrain(power);
-    unsigned long now = millis();
-    while (2.0 * WHEEL_RADIUS * PI * abs(motor::getLeftRotations()) < distance)
-    {
-        taskDelayUntil(&now, MOTOR_POLL_RATE);
-    }
-}
-
-void stop()
-{
-    motor::setLeftDriveTrain(0);
-    motor::setRightDriveTrain(0);
-}
-
-void lift(double target)
-{
-    double error = target - motor::getLiftPos();
-    unsigned long now = millis();
-    if (error > 0)
-    {
-        // going up
-        while (motor::getLiftPos() < target)
-        {
-            motor::setLift(127);
-            taskDelayUntil(&now, MOTOR_POLL_RATE);
-        }
-    }
-    else if (error < 0)
-    {
-        // going down
-        while (motor::getLiftPos() > target)
-        {
-            motor::setLift(-127);
-            taskDelayUntil(&now, MOTOR_POLL_RATE);
-        }
-    }
-    // stop the lift
-    motor::setLift(0);
-}
-
-void claw(motor::Direction direction)
-{
-    motor::setClaw(direction);
-    taskDelay(CLAW_TIME);
-    motor::setClaw(motor::STOP);
-}
-
-void mgl(double target)
-{
-    double error = target - motor::getMglPos();
-    unsigned long now = millis();
-    if (error > 0)
-    {
-        // going up
-        while (motor::getMglPos() < target)
-        {
-            motor::setMgl(63);
-            taskDelayUntil(&now, MOTOR_POLL_RATE);
-        }
-    }
-    else if (error < 0)
-    {
-        // going down
-        while (motor::getMglPos() > target)
-        {
-            motor::setMgl(-63);
-            taskDelayUntil(&now, MOTOR_POLL_RATE);
-        }
-    }
-    // stop the lift
-    motor::setMgl(0);
+    // close the claw on the way down
+    join(claw(CLOSE), lift(0));
 }
@@ -0,0 +1,122 @@
+// defines the executor, which runs every periodic job in one task
+
+#include "main.hpp"
+
+struct JobEntry
+{
+    const char* name;
+    exec::Job job;
+    exec::Phase phase;
+    unsigned int priority;
+    unsigned int period;
+    unsigned int offset;
+    // only the executor changes stats, so it keeps its own copy
+    exec::JobStats stats;
+    shared::Seqlock<exec::JobStats> published;
+};
+
+// sorted by the order they run in
+static JobEntry jobs[MAX_JOBS];
+static unsigned int jobCount = 0;
+static volatile unsigned long tick = 0;
+static volatile unsigned long tickTime = 0;
+static timing::LoopTimer tickTimer("exec", EXEC_TICK);
+
+// whether a job with a certain phase and priority should run before another
+static bool isBefore(exec::Phase phase, unsigned int priority,
+    const JobEntry& b)
+{
+    return phase < b.phase || (phase == b.phase && priority > b.priority);
+}
+
+static void runJob(JobEntry& entry)
+{
+    unsigned long start = micros();
+    entry.job();
+    unsigned long took = micros() - start;
+    exec::JobStats& stats = entry.stats;
+    ++stats.runs;
+    stats.lastTime = took;
+    stats.totalTime += took;
+    if (took > stats.maxTime)
+    {
+        stats.maxTime = took;
+    }
+    entry.published.write(stats);
+}
+
+// declared in main.hpp
+
+bool exec::add(const char* name, Job job, Phase phase, unsigned int priority,
+    unsigned int period, unsigned int offset)
+{
+    if (jobCount >= MAX_JOBS || period == 0)
+    {
+        return false;
+    }
+    // keep the jobs in order so every tick just goes down the list
+    unsigned int index = jobCount;
+    while (index > 0 && isBefore(phase, priority, jobs[index - 1]))
+    {
+        jobs[index] = jobs[index - 1];
+        --index;
+    }
+    JobEntry& entry = jobs[index];
+    entry.name = name;
+    entry.job = job;
+    entry.phase = phase;
+    entry.priority = priority;
+    entry.period = period;
+    entry.offset = offset % period;
+    entry.stats = JobStats();
+    entry.published.write(entry.stats);
+    ++jobCount;
+    return true;
+}
+
+void exec::run(void*)
+{
+    // used for timing cyclic delays
+    unsigned long time = millis();
+    tickTimer.enter();
+    while (true)
+    {
+        tickTime = time;
+        tickTimer.start();
+        for (unsigned int i = 0; i < jobCount; ++i)
+        {
+            if (tick % jobs[i].period == jobs[i].offset)
+            {
+                runJob(jobs[i]);
+            }
+        }
+        tickTimer.stop();
+        ++tick;
+        taskDelayUntil(&time, EXEC_TICK);
+    }
+}
+
+unsigned long exec::getTick()
+{
+    return tick;
+}
+
+unsigned long exec::getTime()
+{
+    return tickTime;
+}
+
+unsigned int exec::getJobCount()
+{
+    return jobCount;
+}
+
+const char* exec::getJobName(unsigned int index)
+{
+    return index < jobCount ? jobs[index].name : "";
+}
+
+exec::JobStats exec::getJobStats(unsigned int index)
+{
+    return index < jobCount ? jobs[index].published.read() : JobStats();
+}
@@ -0,0 +1,344 @@
+// defines the MotorFrame, which batches up motor outputs
+
+#include "main.hpp"
+
+// 393 motors in high torque mode, for the current model
+#define NOMINAL_VOLTAGE 7200 // mV
+#define STALL_CURRENT 4800 // mA per motor
+#define FREE_SPEED 100 // rpm
+#define MAX_OUTPUT 127
+// battery is sampled every this many flushes
+#define BATTERY_SAMPLE_RATE 10
+// each sample moves the estimate 1/BATTERY_FILTER of the way towards it
+#define BATTERY_FILTER 4
+
+static int clamp(int output)
+{
+    if (output > MAX_OUTPUT)
+    {
+        return MAX_OUTPUT;
+    }
+    if (output < -MAX_OUTPUT)
+    {
+        return -MAX_OUTPUT;
+    }
+    return output;
+}
+
+// the part of an output that the motor's back EMF cancels out at a speed
+static int getBackEmf(int rpm)
+{
+    return rpm * MAX_OUTPUT / FREE_SPEED;
+}
+
+// declared in main.hpp
+
+motor::MotorFrame::MotorFrame(unsigned int invertedPorts):
+    invertedPorts(invertedPorts), writing(0), finished(0), stale(true),
+    sets(0), writesSaved(0),
+    totalWritesSaved(0), currentBudget(0), compensatedPorts(0), battery(0),
+    flushesUntilSample(0)
+{
+    for (unsigned char i = 0; i < PORT_COUNT; ++i)
+    {
+        staged[i] = 0;
+        committed[i] = 0;
+        written[i] = 0;
+        applied[i] = 0;
+        slewRates[i] = 0;
+        motorCounts[i] = 1;
+        speeds[i] = 0;
+    }
+    outputStats.slewLimited = 0;
+    outputStats.governed = 0;
+    outputStats.minScale = 100;
+    outputStats.lastCurrent = 0;
+    outputStats.peakCurrent = 0;
+}
+
+void motor::MotorFrame::set(unsigned char port, int speed)
+{
+    staged[port - 1] = speed;
+    ++sets;
+}
+
+void motor::MotorFrame::beginWrite()
+{
+    __sync_fetch_and_add(&writing, 1);
+}
+
+void motor::MotorFrame::endWrite()
+{
+    // counted as finished before it stops counting as going on, so a flush
+    //  that sees nothing going on also sees that something changed
+    __sync_fetch_and_add(&finished, 1);
+    __sync_fetch_and_sub(&writing, 1);
+}
+
+int motor::MotorFrame::get(unsigned char port) const
+{
+    return staged[port - 1];
+}
+
+int motor::MotorFrame::getOutput(unsigned char port) const
+{
+    return applied[port - 1];
+}
+
+void motor::MotorFrame::flush()
+{
+    // the motors are stopped while disabled, so what we wrote before doesn't
+    //  mean anything anymore
+    if (!isEnabled())
+    {
+        stale = true;
+        sets = 0;
+        for (unsigned char i = 0; i < PORT_COUNT; ++i)
+        {
+            applied[i] = 0;
+        }
+        return;
+    }
+    sampleBattery();
+    // only take the staged outputs if no write was going on the whole time
+    //  they were being copied, like a Seqlock read that doesn't retry
+    int outputs[PORT_COUNT];
+    unsigned long before = finished;
+    __sync_synchronize();
+    bool whole = writing == 0;
+    for (unsigned char i = 0; i < PORT_COUNT && whole; ++i)
+    {
+        outputs[i] = staged[i];
+    }
+    __sync_synchronize();
+    if (whole && writing == 0 && finished == before)
+    {
+        for (unsigned char i = 0; i < PORT_COUNT; ++i)
+        {
+            committed[i] = outputs[i];
+        }
+    }
+    for (unsigned char port = 1; port <= PORT_COUNT; ++port)
+    {
+        outputs[port - 1] = slew(port,
+            compensate(port, clamp(committed[port - 1])));
+    }
+    govern(outputs);
+    unsigned int writes = 0;
+    for (unsigned char port = 1; port <= PORT_COUNT; ++port)
+    {
+        int speed = outputs[port - 1];
+        applied[port - 1] = speed;
+        if (invertedPorts & (1u << port))
+        {
+            speed = -speed;
+        }
+        if (stale || speed != written[port - 1])
+        {
+            motorSet(port, speed);
+            written[port - 1] = speed;
+            ++writes;
+        }
+    }
+    stale = false;
+    // every set() would've been a motorSet() call without the frame
+    unsigned int requested = sets;
+    sets = 0;
+    writesSaved = requested > writes ? requested - writes : 0;
+    totalWritesSaved += writesSaved;
+}
+
+unsigned int motor::MotorFrame::getWritesSaved() const
+{
+    return writesSaved;
+}
+
+unsigned long motor::MotorFrame::getTotalWritesSaved() const
+{
+    return totalWritesSaved;
+}
+
+void motor::MotorFrame::setSlewRate(unsigned char port, int rate)
+{
+    slewRates[port - 1] = rate;
+}
+
+void motor::MotorFrame::setMotorCount(unsigned char port, unsigned int count)
+{
+    motorCounts[port - 1] = count;
+}
+
+void motor::MotorFrame::setSpeed(unsigned char port, int rpm)
+{
+    speeds[port - 1] = rpm;
+}
+
+void motor::MotorFrame::setCurrentBudget(unsigned long budget)
+{
+    currentBudget = budget;
+}
+
+void motor::MotorFrame::setCompensated(unsigned char port, bool compensated)
+{
+    if (compensated)
+    {
+        compensatedPorts |= 1u << port;
+    }
+    else
+    {
+        compensatedPorts &= ~(1u << port);
+    }
+}
+
+unsigned int motor::MotorFrame::getBattery() const
+{
+    return battery;
+}
+
+motor::OutputStats motor::MotorFrame::getOutputStats() const
+{
+    return outputStats;
+}
+
+void motor::MotorFrame::sampleBattery()
+{
+    if (flushesUntilSample > 0)
+    {
+        --flushesUntilSample;
+        return;
+    }
+    flushesUntilSample = BATTERY_SAMPLE_RATE - 1;
+    int sample = powerLevelMain();
+    // powerLevelMain() reads 0 if it can't measure the battery
+    if (sample == 0)
+    {
+        return;
+    }
+    if (battery == 0)
+    {
+        battery = sample;
+        return;
+    }
+    battery += (sample - (int) battery) / BATTERY_FILTER;
+}
+
+int motor::MotorFrame::compensate(unsigned char port, int output) const
+{
+    if (battery == 0 || !(compensatedPorts & (1u << port)))
+    {
+        return output;
+    }
+    // round to the nearest output instead of towards 0
+    long scaled = (long) output * NOMINAL_VOLTAGE;
+    long half = battery / 2;
+    return clamp((int) ((scaled + (scaled < 0 ? -half : half)) /
+        (long) battery));
+}
+
+int motor::MotorFrame::slew(unsigned char port, int output)
+{
+    int last = applied[port - 1];
+    int rate = slewRates[port - 1];
+    if (rate <= 0)
+    {
+        return output;
+    }
+    // a port that's reversing stops first, then speeds up from 0
+    if ((last > 0 && output < 0) || (last < 0 && output > 0))
+    {
+        last = 0;
+    }
+    // going towards 0 isn't limited, so stopping doesn't keep the motors
+    //  going for another few flushes
+    if (output >= 0 ? output <= last : output >= last)
+    {
+        return output;
+    }
+    if (output > last + rate)
+    {
+        ++outputStats.slewLimited;
+        return last + rate;
+    }
+    if (output < last - rate)
+    {
+        ++outputStats.slewLimited;
+        return last - rate;
+    }
+    return output;
+}
+
+unsigned long motor::MotorFrame::getCurrent(unsigned char port, int output,
+    unsigned int voltage) const
+{
+    // a port that's set to 0 just coasts
+    if (output == 0)
+    {
+        return 0;
+    }
+    // how hard the motor is being driven compared to how fast it's already
+    //  going, in the same units as an output
+    long drive = (long) output * (long) voltage / NOMINAL_VOLTAGE -
+        getBackEmf(speeds[port - 1]);
+    if (drive < 0)
+    {
+        drive = -drive;
+    }
+    return motorCounts[port - 1] * STALL_CURRENT * drive / MAX_OUTPUT;
+}
+
+void motor::MotorFrame::govern(int* outputs)
+{
+    // the model needs a voltage even before the first battery sample
+    unsigned int voltage = battery != 0 ? battery : NOMINAL_VOLTAGE;
+    unsigned long total = 0;
+    for (unsigned char port = 1; port <= PORT_COUNT; ++port)
+    {
+        total += getCurrent(port, outputs[port - 1], voltage);
+    }
+    outputStats.lastCurrent = total;
+    if (total > outputStats.peakCurrent)
+    {
+        outputStats.peakCurrent = total;
+    }
+    if (currentBudget == 0 || total <= currentBudget)
+    {
+        return;
+    }
+    // every port gets its current scaled down by the same amount, so no
+    //  subsystem gets starved to feed another one
+    // the current is proportional to the drive, not the output, so the
+    //  back EMF has to be taken out first and put back afterwards
+    long scale = (long) (currentBudget * 256 / total);
+    for (unsigned char port = 1; port <= PORT_COUNT; ++port)
+    {
+        int output = outputs[port - 1];
+        if (output == 0)
+        {
+            continue;
+        }
+        long backEmf = getBackEmf(speeds[port - 1]);
+        long drive = (long) output * (long) voltage / NOMINAL_VOLTAGE -
+            backEmf;
+        drive = drive * scale / 256;
+        int governed = clamp((int) ((drive + backEmf) * NOMINAL_VOLTAGE /
+            (long) voltage));
+        // scaling the drive moves the output towards the back EMF, which is
+        //  further from 0 when the motor's going faster than its output
+        //  would take it, but governing should only ever take power away
+        if ((output > 0 && governed < 0) || (output < 0 && governed > 0))
+        {
+            governed = 0;
+        }
+        else if (abs(governed) > abs(output))
+        {
+            governed = output;
+        }
+        outputs[port - 1] = governed;
+    }
+    ++outputStats.governed;
+    unsigned int percent = (unsigned int) (scale * 100 / 256);
+    if (percent < outputStats.minScale)
+    {
+        outputStats.minScale = percent;
+    }
+}
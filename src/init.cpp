@@ -2,8 +2,22 @@
 
 #include "main.hpp"
 
+// adds a job to the executor, complaining if it didn't fit since nothing
+//  would ever run it
+static void addJob(const char* name, exec::Job job, exec::Phase phase,
+    unsigned int priority, unsigned int period, unsigned int offset)
+{
+    if (!exec::add(name, job, phase, priority, period, offset))
+    {
+        printf("ERROR: COULDN'T ADD JOB %s (%u jobs, MAX_JOBS is %d)\n"
+            "EXPECT UNRELIABLE BEHAVIOR\n", name, exec::getJobCount(),
+            MAX_JOBS);
+    }
+}
+
 // declared in main.hpp
 auton::AutonID auton::autonid = NOTHING;
+unsigned int auton::scriptid = 0;
 
 // pre-initialization code, mostly just setting default pin modes and port
 //  states and stuff
@@ -20,6 +34,40 @@ void initialize()
 {
     setTeamName(TEAM_NAME);
     motor::init();
-    taskCreate(lcd::controller, TASK_DEFAULT_STACK_SIZE, NULL,
-        TASK_PRIORITY_DEFAULT - 1);
+    sensor::initGyro();
+    lcd::init();
+    live::init();
+    auton::init();
+    auton::findScripts();
+    input::init();
+    // everything that runs periodically goes through the executor, so the
+    //  sensors are always read before the controllers run and the motors
+    //  are always written right after
+    addJob("sense", motor::sense, exec::SENSE, 0, ODOM_RATE / EXEC_TICK, 0);
+    // the driver and the actions go before the lift controller, so a lift
+    //  target they set gets worked on in the same tick
+    addJob("driver", input::update, exec::CONTROL, 1,
+        MOTOR_POLL_RATE / EXEC_TICK, 0);
+    addJob("auton", auton::control, exec::CONTROL, 1,
+        MOTOR_POLL_RATE / EXEC_TICK, 0);
+    addJob("lift", motor::controlLift, exec::CONTROL, 0,
+        MOTOR_POLL_RATE / EXEC_TICK, 0);
+    addJob("flush", motor::flush, exec::ACTUATE, 0,
+        MOTOR_POLL_RATE / EXEC_TICK, 0);
+    // the lcd doesn't have to be on time, so it goes on a tick where the
+    //  motors aren't being run
+    addJob("lcd", lcd::update, exec::REPORT, 0, LCD_RATE / EXEC_TICK, 2);
+    addJob("battery", telemetry::logBattery, exec::REPORT, 0,
+        1000 / EXEC_TICK, 3);
+    addJob("live", live::sample, exec::REPORT, 0, LIVE_RATE / EXEC_TICK, 0);
+    taskCreate(exec::run, TASK_DEFAULT_STACK_SIZE, NULL,
+        TASK_PRIORITY_DEFAULT + 1);
+    taskCreate(input::streamer, TASK_DEFAULT_STACK_SIZE, NULL,
+        TASK_PRIORITY_LOWEST + 1);
+    taskCreate(telemetry::writer, TASK_DEFAULT_STACK_SIZE, NULL,
+        TASK_PRIORITY_LOWEST + 1);
+    taskCreate(live::sender, TASK_DEFAULT_STACK_SIZE, NULL,
+        TASK_PRIORITY_LOWEST + 1);
+    taskCreate(timing::dumper, TASK_DEFAULT_STACK_SIZE, NULL,
+        TASK_PRIORITY_LOWEST + 1);
 }
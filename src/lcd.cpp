@@ -4,8 +4,10 @@
 
 // what port the LCD screen goes into
 #define LCD_PORT uart1
-// amount of milliseconds between each LCD update
-#define LCD_POLL_SPEED 100ul
+// amount of characters on each line of the LCD
+#define LCD_WIDTH 16
+// amount of bytes sent over the UART each time a line is set
+#define LCD_PACKET_SIZE 22
 
 // the different types of things the LCD can do
 enum LoopState
@@ -14,6 +16,12 @@ enum LoopState
     AUTON_SELECT,
     // display primary/backup battery voltage
     DISPLAY_BATTERY,
+    // display where the odometry thinks the robot is
+    DISPLAY_POSE,
+    // display how often the motor outputs were held back
+    DISPLAY_LIMITER,
+    // display how well each loop keeps to its period
+    DISPLAY_TIMING,
     // control the lift from the LCD
     LIFT_CONTROL
 };
@@ -47,84 +55,186 @@ private:
     unsigned int previous;
 };
 
+// UART and CPU usage, see lcd::getStats()
+static lcd::Stats stats = {0, 0, 0, 0};
+
+// keeps what's on the LCD so only the lines that changed get sent to it
+class Screen
+{
+public:
+    Screen(FILE* lcdPort): lcdPort(lcdPort)
+    {
+        lines[0][0] = '\0';
+        lines[1][0] = '\0';
+        // nothing's been sent yet, so make sure the first lines always are
+        valid[0] = false;
+        valid[1] = false;
+    }
+
+    // sets the text of a line (1 or 2), but only sends it if it changed
+    void setLine(unsigned char line, const char* text)
+    {
+        char* current = lines[line - 1];
+        stats.bytesWithoutDiff += LCD_PACKET_SIZE;
+        // copy the new text over while checking if anything's different
+        bool changed = !valid[line - 1];
+        unsigned int i = 0;
+        for (; i < LCD_WIDTH && text[i] != '\0'; ++i)
+        {
+            changed = changed || current[i] != text[i];
+            current[i] = text[i];
+        }
+        changed = changed || current[i] != '\0';
+        current[i] = '\0';
+        if (!changed)
+        {
+            return;
+        }
+        valid[line - 1] = true;
+        lcdSetText(lcdPort, line, current);
+        stats.bytesSent += LCD_PACKET_SIZE;
+    }
+
+private:
+    FILE* lcdPort;
+    char lines[2][LCD_WIDTH + 1];
+    bool valid[2];
+};
+
 // corresponds to state_t enum
-// takes a reference to the ButtonState, returns what the LoopState should be
-//  changed to
-static LoopState autonSelect(const ButtonState& buttons);
-static LoopState displayBattery(const ButtonState& buttons);
-static LoopState liftControl(const ButtonState& buttons);
+// takes a reference to the ButtonState and the Screen to draw on, returns
+//  what the LoopState should be changed to
+static LoopState autonSelect(const ButtonState& buttons, Screen& screen);
+static LoopState displayBattery(const ButtonState& buttons, Screen& screen);
+static LoopState displayPose(const ButtonState& buttons, Screen& screen);
+static LoopState displayLimiter(const ButtonState& buttons, Screen& screen);
+static LoopState displayTiming(const ButtonState& buttons, Screen& screen);
+static LoopState liftControl(const ButtonState& buttons, Screen& screen);
+
+// writes value / scale with a certain amount of decimal places into buffer
+//  without using any floating point math, returns buffer
+static const char* formatFixed(char* buffer, long value, long scale,
+    unsigned int decimals);
+
+static timing::LoopTimer loopTimer("lcd", LCD_RATE);
+// the action that should be taken, kinda like a state machine
+static LoopState loopState = LIFT_CONTROL;
+// tells loop functions what buttons are being pressed
+static ButtonState buttons(LCD_PORT);
+// what loop functions draw on
+static Screen screen(LCD_PORT);
 
 // declared in main.hpp
-void lcd::controller(void*)
+void lcd::init()
 {
     lcdInit(LCD_PORT);
     lcdClear(LCD_PORT);
     lcdSetBacklight(LCD_PORT, false);
-    // the action that should be taken, kinda like a state machine
-    LoopState loopState = LIFT_CONTROL;
-    // tells loop functions what buttons are being pressed
-    ButtonState buttons(LCD_PORT);
-    // used for timing cyclic delays
-    unsigned long time = millis();
-    while (true)
-    {
-        buttons.poll();
-        // do a different loop action based on loopState
-        switch (loopState)
-        {
-        case AUTON_SELECT:
-            loopState = autonSelect(buttons);
-            break;
-        case DISPLAY_BATTERY:
-            loopState = displayBattery(buttons);
-            break;
-        case LIFT_CONTROL:
-            loopState = liftControl(buttons);
-            break;
-        }
-        // wait a bit before receiving input again
-        taskDelayUntil(&time, LCD_POLL_SPEED);
+}
+
+void lcd::update()
+{
+    loopTimer.start();
+    unsigned long start = micros();
+    buttons.poll();
+    // do a different loop action based on loopState
+    switch (loopState)
+    {
+    case AUTON_SELECT:
+        loopState = autonSelect(buttons, screen);
+        break;
+    case DISPLAY_BATTERY:
+        loopState = displayBattery(buttons, screen);
+        break;
+    case DISPLAY_POSE:
+        loopState = displayPose(buttons, screen);
+        break;
+    case DISPLAY_LIMITER:
+        loopState = displayLimiter(buttons, screen);
+        break;
+    case DISPLAY_TIMING:
+        loopState = displayTiming(buttons, screen);
+        break;
+    case LIFT_CONTROL:
+        loopState = liftControl(buttons, screen);
+        break;
     }
+    stats.lastTickTime = micros() - start;
+    if (stats.lastTickTime > stats.maxTickTime)
+    {
+        stats.maxTickTime = stats.lastTickTime;
+    }
+    loopTimer.stop();
+}
+
+lcd::Stats lcd::getStats()
+{
+    return stats;
 }
 
-LoopState autonSelect(const ButtonState& buttons)
+LoopState autonSelect(const ButtonState& buttons, Screen& screen)
 {
     // so we don't have to type "auton::" 5 billion times
     using namespace auton;
     // used for printing the name of an autonomous program
-    static const char* autonNames[AUTONID_MAX + 1] =
+    // scripts use their file name instead
+    static const char* autonNames[SCRIPT] =
     {
         "Nothing",
         "Forward+Backward",
         "MG+Cone Left",
         "MG+Cone Right",
-        "Score Stationary"
+        "Score Stationary",
+        "Replay Driver"
     };
     // see if the left/right buttons were just pressed
     bool left = buttons.justPressed(LCD_BTN_LEFT);
     bool right = buttons.justPressed(LCD_BTN_RIGHT);
-    // if left, go up the autonNames list
+    // if left, go up the autonNames list, then the script list
     if (left && !right)
     {
-        autonid = (AutonID) (autonid - 1);
-        if (autonid < AUTONID_MIN || autonid > AUTONID_MAX)
+        if (autonid == SCRIPT && scriptid > 0)
         {
-            // go back to the end of the list
-            autonid = AUTONID_MAX;
+            --scriptid;
+        }
+        else
+        {
+            autonid = (AutonID) (autonid - 1);
+            if (autonid < AUTONID_MIN || autonid > AUTONID_MAX)
+            {
+                // go back to the end of the list
+                autonid = AUTONID_MAX;
+                scriptid = getScriptCount() - 1;
+            }
+            if (autonid == SCRIPT && getScriptCount() == 0)
+            {
+                // there aren't any scripts to pick
+                autonid = (AutonID) (SCRIPT - 1);
+            }
         }
     }
-    // if right, go down the autonNames list
+    // if right, go down the autonNames list, then the script list
     else if (!left && right)
     {
-        autonid = (AutonID) (autonid + 1);
-        if (autonid < AUTONID_MIN || autonid > AUTONID_MAX)
+        if (autonid == SCRIPT && scriptid + 1 < getScriptCount())
         {
-            // go back to the start of the list
-            autonid = AUTONID_MIN;
+            ++scriptid;
+        }
+        else
+        {
+            autonid = (AutonID) (autonid + 1);
+            scriptid = 0;
+            if (autonid < AUTONID_MIN || autonid > AUTONID_MAX ||
+                (autonid == SCRIPT && getScriptCount() == 0))
+            {
+                // go back to the start of the list
+                autonid = AUTONID_MIN;
+            }
         }
     }
-    lcdSetText(LCD_PORT, 1, ROBOT_NAME " will do:");
-    lcdSetText(LCD_PORT, 2, autonNames[autonid]);
+    screen.setLine(1, ROBOT_NAME " will do:");
+    screen.setLine(2, autonid == SCRIPT ? getScriptName(scriptid) :
+        autonNames[autonid]);
     // if auton selected or enabled by comp switch, start displaying battery
     if (buttons.justPressed(LCD_BTN_CENTER))
     {
@@ -133,36 +243,177 @@ LoopState autonSelect(const ButtonState& buttons)
     return AUTON_SELECT;
 }
 
-LoopState displayBattery(const ButtonState& buttons)
+LoopState displayBattery(const ButtonState& buttons, Screen& screen)
 {
-    lcdPrint(LCD_PORT, 1, "Primary: %.1fV", powerLevelMain() / 1000.0f);
-    lcdPrint(LCD_PORT, 2, "Backup:  %.1fV", powerLevelBackup() / 1000.0f);
+    char number[LCD_WIDTH + 1];
+    char line[LCD_WIDTH + 1];
+    // power levels are in millivolts
+    snprintf(line, sizeof(line), "Primary: %sV",
+        formatFixed(number, powerLevelMain(), 1000, 1));
+    screen.setLine(1, line);
+    snprintf(line, sizeof(line), "Backup:  %sV",
+        formatFixed(number, powerLevelBackup(), 1000, 1));
+    screen.setLine(2, line);
     if (buttons.justPressed(LCD_BTN_CENTER))
     {
-        return LIFT_CONTROL;
+        return DISPLAY_POSE;
     }
     return DISPLAY_BATTERY;
 }
 
-LoopState liftControl(const ButtonState& buttons)
+LoopState displayPose(const ButtonState& buttons, Screen& screen)
 {
-    lcdPrint(LCD_PORT, 1, "lift pos = %.1f", motor::getLiftPos());
-    lcdSetText(LCD_PORT, 2, "v              ^");
+    odom::Pose pose = odom::getPose();
+    char line[LCD_WIDTH + 1];
+    // positions are shown in inches
+    snprintf(line, sizeof(line), "x=%ld y=%ld", odom::toSixteenths(pose.x) / 16,
+        odom::toSixteenths(pose.y) / 16);
+    screen.setLine(1, line);
+    snprintf(line, sizeof(line), "heading=%ld", odom::toDegrees(pose.heading));
+    screen.setLine(2, line);
+    if (buttons.justPressed(LCD_BTN_CENTER))
+    {
+        return DISPLAY_LIMITER;
+    }
+    return DISPLAY_POSE;
+}
+
+LoopState displayLimiter(const ButtonState& buttons, Screen& screen)
+{
+    motor::OutputStats outputs = motor::getFrame().getOutputStats();
+    char number[LCD_WIDTH + 1];
+    char line[LCD_WIDTH + 1];
+    snprintf(line, sizeof(line), "slw%lu gov%lu", outputs.slewLimited,
+        outputs.governed);
+    screen.setLine(1, line);
+    // currents are in milliamps
+    snprintf(line, sizeof(line), "%sA min%u%%",
+        formatFixed(number, outputs.peakCurrent, 1000, 1), outputs.minScale);
+    screen.setLine(2, line);
+    if (buttons.justPressed(LCD_BTN_CENTER))
+    {
+        return DISPLAY_TIMING;
+    }
+    return DISPLAY_LIMITER;
+}
+
+LoopState displayTiming(const ButtonState& buttons, Screen& screen)
+{
+    // which timer is being shown
+    static unsigned int index = 0;
+    if (buttons.justPressed(LCD_BTN_RIGHT))
+    {
+        ++index;
+    }
+    if (index >= timing::getTimerCount())
+    {
+        index = 0;
+    }
+    const timing::LoopTimer* timer = timing::getTimer(index);
+    char line[LCD_WIDTH + 1];
+    if (timer == NULL)
+    {
+        screen.setLine(1, "no loops timed");
+        screen.setLine(2, "");
+    }
+    else
+    {
+        snprintf(line, sizeof(line), "%s miss%lu", timer->getName(),
+            timer->getMisses());
+        screen.setLine(1, line);
+        // times are in microseconds
+        snprintf(line, sizeof(line), "j%lu x%lu", timer->getMaxJitter(),
+            timer->getMaxExecTime());
+        screen.setLine(2, line);
+    }
+    // the whole histograms don't fit, so they go over the serial console,
+    //  which takes too long to do from the executor
+    if (buttons.justPressed(LCD_BTN_LEFT))
+    {
+        timing::requestDump();
+    }
+    if (buttons.justPressed(LCD_BTN_CENTER))
+    {
+        return LIFT_CONTROL;
+    }
+    return DISPLAY_TIMING;
+}
+
+LoopState liftControl(const ButtonState& buttons, Screen& screen)
+{
+    char number[LCD_WIDTH + 1];
+    char line[LCD_WIDTH + 1];
+    snprintf(line, sizeof(line), "lift pos = %s", formatFixed(number,
+        motor::getLiftPosition().get(), 1 << LIFT_UNIT_SHIFT, 1));
+    screen.setLine(1, line);
+    // the longest an lcd tick took, which hardly ever changes so it doesn't
+    //  get sent every tick
+    snprintf(line, sizeof(line), "v   %6luus   ^", stats.maxTickTime);
+    screen.setLine(2, line);
+    // the lift only gets told what to do when the buttons change, so it isn't
+    //  taken away from the lift controller every tick, but letting go of a
+    //  button always stops it, even in autonomous
+    static int lastPower = 0;
+    int power = 0;
     if (buttons.pressed(LCD_BTN_LEFT))
     {
-        motor::setLift(-127);
+        power = -127;
     }
     else if (buttons.pressed(LCD_BTN_RIGHT))
     {
-        motor::setLift(127);
+        power = 127;
     }
-    else if (!isJoystickConnected(1))
+    if (power != lastPower)
     {
-        motor::setLift(0);
+        motor::setLift(power);
     }
+    lastPower = power;
     if (buttons.justPressed(LCD_BTN_CENTER))
     {
         return AUTON_SELECT;
     }
     return LIFT_CONTROL;
 }
+
+const char* formatFixed(char* buffer, long value, long scale,
+    unsigned int decimals)
+{
+    // scale the value so the decimals we want are in the integer part,
+    //  rounding to the nearest one
+    unsigned long multiplier = 1;
+    for (unsigned int i = 0; i < decimals; ++i)
+    {
+        multiplier *= 10;
+    }
+    bool negative = value < 0;
+    unsigned long magnitude = negative ? -value : value;
+    unsigned long digits = (magnitude * multiplier + scale / 2) / scale;
+    // build it backwards, then flip it around
+    char reversed[LCD_WIDTH + 1];
+    unsigned int length = 0;
+    for (unsigned int i = 0; i < decimals; ++i)
+    {
+        reversed[length++] = '0' + digits % 10;
+        digits /= 10;
+    }
+    if (decimals > 0)
+    {
+        reversed[length++] = '.';
+    }
+    do
+    {
+        reversed[length++] = '0' + digits % 10;
+        digits /= 10;
+    }
+    while (digits > 0 && length < LCD_WIDTH);
+    if (negative && length < LCD_WIDTH)
+    {
+        reversed[length++] = '-';
+    }
+    for (unsigned int i = 0; i < length; ++i)
+    {
+        buffer[i] = reversed[length - 1 - i];
+    }
+    buffer[length] = '\0';
+    return buffer;
+}
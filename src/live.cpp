@@ -0,0 +1,178 @@
+// streams packets of telemetry over uart2 without making the control loop
+//  wait on the UART
+//
+// sample() runs in the executor and puts finished frames in a buffer, and
+//  the sender task takes whatever's in there out in big chunks, so the
+//  executor never calls fwrite() and a slow UART only drops packets
+
+#include "main.hpp"
+#include "telemetry.hpp"
+
+// what port the laptop's serial adapter goes into
+#define LIVE_PORT uart2
+#define LIVE_BAUD 115200
+// bytes of frames that can be waiting to be sent, has to be a power of 2
+#define BUFFER_SIZE 1024u
+// how often the sender gives the UART more bytes in ms, and the most it
+//  gives it at a time (115200 baud is about 115 bytes every 10 ms)
+#define SEND_RATE 10
+#define SEND_SIZE 128u
+
+// frames waiting to go out, only sample() moves queued and only the sender
+//  moves sent
+static unsigned char buffer[BUFFER_SIZE];
+static volatile unsigned long queued = 0;
+static volatile unsigned long sent = 0;
+
+// every how many samples each channel gets sent, 0 for never
+static volatile unsigned int decimations[live::CHANNEL_COUNT];
+// samples since each channel was last sent
+static unsigned int counters[live::CHANNEL_COUNT];
+static unsigned int sequence = 0;
+
+static live::Stats stats = {0, 0, 0, 0, 0};
+static timing::LoopTimer sendTimer("live", SEND_RATE);
+
+// reads the current value of a channel
+static long read(live::Channel channel, const odom::Pose& pose)
+{
+    switch (channel)
+    {
+    case live::CHANNEL_LEFT:
+        return motor::getLeftCounts().get();
+    case live::CHANNEL_RIGHT:
+        return motor::getRightCounts().get();
+    case live::CHANNEL_LIFT:
+        return motor::getLiftPosition().get();
+    case live::CHANNEL_X:
+        return odom::toSixteenths(pose.x);
+    case live::CHANNEL_Y:
+        return odom::toSixteenths(pose.y);
+    case live::CHANNEL_HEADING:
+        return pose.heading;
+    case live::CHANNEL_BATTERY:
+        return motor::getFrame().getBattery();
+    default:
+        return 0;
+    }
+}
+
+// puts a frame in the buffer, or drops it if there isn't room for all of it
+static void queue(const unsigned char* frame, unsigned int size)
+{
+    unsigned long backlog = queued - sent;
+    if (backlog + size > BUFFER_SIZE)
+    {
+        ++stats.dropped;
+        return;
+    }
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        buffer[(queued + i) % BUFFER_SIZE] = frame[i];
+    }
+    // the sender has to see the bytes before it sees they're there
+    __sync_synchronize();
+    queued += size;
+    if (backlog + size > stats.maxBacklog)
+    {
+        stats.maxBacklog = backlog + size;
+    }
+}
+
+// declared in main.hpp
+
+void live::init()
+{
+    usartInit(LIVE_PORT, LIVE_BAUD, SERIAL_8N1);
+    setDecimation(CHANNEL_LEFT, 1);
+    setDecimation(CHANNEL_RIGHT, 1);
+    setDecimation(CHANNEL_LIFT, 2);
+    setDecimation(CHANNEL_X, 1);
+    setDecimation(CHANNEL_Y, 1);
+    setDecimation(CHANNEL_HEADING, 1);
+    setDecimation(CHANNEL_BATTERY, 1000 / LIVE_RATE);
+}
+
+void live::setDecimation(Channel channel, unsigned int decimation)
+{
+    if (channel < CHANNEL_COUNT)
+    {
+        decimations[channel] = decimation;
+    }
+}
+
+void live::sample()
+{
+    unsigned char packet[LIVE_PACKET_SIZE];
+    unsigned int size = LIVE_HEADER_SIZE;
+    unsigned int mask = 0;
+    odom::Pose pose = odom::getPose();
+    for (unsigned int i = 0; i < CHANNEL_COUNT; ++i)
+    {
+        unsigned int decimation = decimations[i];
+        if (decimation == 0 || ++counters[i] < decimation)
+        {
+            continue;
+        }
+        counters[i] = 0;
+        mask |= 1 << i;
+        telemetry::putLong(packet + size, read((Channel) i, pose));
+        size += LIVE_VALUE_SIZE;
+    }
+    if (mask == 0)
+    {
+        return;
+    }
+    telemetry::putShort(packet, sequence++ & 0xffff);
+    telemetry::putLong(packet + 2, millis());
+    telemetry::putShort(packet + 6, mask);
+    telemetry::putShort(packet + size, crc16(packet, size));
+    size += LIVE_CRC_SIZE;
+    unsigned char frame[LIVE_FRAME_SIZE];
+    unsigned int length = encode(packet, size, frame);
+    frame[length++] = 0;
+    ++stats.packets;
+    queue(frame, length);
+}
+
+void live::sender(void*)
+{
+    // used for timing cyclic delays
+    unsigned long time = millis();
+    sendTimer.enter();
+    while (true)
+    {
+        sendTimer.start();
+        unsigned long backlog = queued - sent;
+        // the bytes have to be read after queued is
+        __sync_synchronize();
+        if (backlog > SEND_SIZE)
+        {
+            backlog = SEND_SIZE;
+        }
+        while (backlog > 0)
+        {
+            // the buffer might wrap around in the middle of the batch
+            unsigned long start = sent % BUFFER_SIZE;
+            unsigned long size = BUFFER_SIZE - start;
+            if (size > backlog)
+            {
+                size = backlog;
+            }
+            fwrite(buffer + start, 1, size, LIVE_PORT);
+            stats.bytes += size;
+            ++stats.writes;
+            // the bytes have to be sent before they can be written over
+            __sync_synchronize();
+            sent += size;
+            backlog -= size;
+        }
+        sendTimer.stop();
+        taskDelayUntil(&time, SEND_RATE);
+    }
+}
+
+live::Stats live::getStats()
+{
+    return stats;
+}
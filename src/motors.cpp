@@ -14,8 +14,32 @@
 #define MGL_RIGHT 9
 #define CLAW 10
 
-// amount of ports on the cortex
-#define PORT_COUNT 10
+// which ports get driven together, negative ports are wired backwards
+typedef motor::MotorGroup<-LIFT_BL, -LIFT_TL, LIFT_BR, LIFT_TR> Lift;
+typedef motor::MotorGroup<MGL_LEFT, -MGL_RIGHT> Mgl;
+typedef motor::MotorGroup<DRIVE_LEFT> LeftDrive;
+typedef motor::MotorGroup<-DRIVE_RIGHT> RightDrive;
+typedef motor::MotorGroup<CLAW> Claw;
+typedef motor::MotorGroup<TWISTY_BOI> TwistyBoi;
+
+static_assert(motor::areMasksDisjoint(Lift::getPorts(), Mgl::getPorts(),
+    LeftDrive::getPorts(), RightDrive::getPorts(), Claw::getPorts(),
+    TwistyBoi::getPorts()), "a port is in more than one motor group");
+
+// ports whose motors are wired backwards
+#define INVERTED_PORTS (Lift::getInverted() | Mgl::getInverted() | \
+    LeftDrive::getInverted() | RightDrive::getInverted() | \
+    Claw::getInverted() | TwistyBoi::getInverted())
+
+// the most each port's output can change by per MOTOR_POLL_RATE, which keeps
+//  the motors from pulling current spikes that trip the PTCs
+#define LIFT_SLEW 25 // 0 to full power in 100ms
+#define MGL_SLEW 25
+#define DRIVE_SLEW 25
+// the most current (mA) all the motors are allowed to pull together
+#define CURRENT_BUDGET 16000ul
+// motors on each drive train port, they're y-cabled
+#define DRIVE_MOTORS 2
 
 // IME network
 #define IME_RIGHT 0
@@ -31,16 +55,97 @@
 
 #define MAX_POS 127.0
 #define MIN_POS 0.0
-#define COUNTS_PER_REV_TORQUE 627.2 // IME counts per rev in high torque mode
 #define LIFT_MAX_REVS 4.4
 #define MGL_MAX_REVS 3.0
+// what imeGetVelocity() should be divided by to get rpm in high torque mode
+#define RPM_DIVISOR_TORQUE 39.2
+// position units per IME count, see LIFT_UNIT_SHIFT
+#define LIFT_UNITS_PER_COUNT (MAX_POS * (1 << LIFT_UNIT_SHIFT) / \
+    (LIFT_MAX_REVS * COUNTS_PER_REV_TORQUE))
+
+// the lift controller is all integer math, and it keeps motor power in the
+//  same fixed point as LiftUnits so a gain times a position comes out in it
+#define LIFT_ONE (1l << LIFT_UNIT_SHIFT)
+// lift controller gains, in motor power per position unit (per second)
+// not in parentheses to take advantage of only doing integer arithmetic
+#define LIFT_KP 20
+#define LIFT_KI 4
+#define LIFT_KD 3 / 10
+// power needed to keep the lift from falling down
+#define LIFT_KG 15
+// the most power the integral term is allowed to add
+#define LIFT_I_MAX 40
+// how close the lift has to be to its target for the integral to build up,
+//  so it doesn't wind up during the whole approach
+#define LIFT_I_BAND 4
+// how close the lift has to be to its target to be considered settled
+#define LIFT_TOLERANCE 2
+// how slow the lift has to be moving (units/s) to be considered settled
+#define LIFT_SETTLE_SPEED 5
+// how long the lift has to stay in tolerance to be considered settled (ms)
+#define LIFT_SETTLE_TIME 60ul
+
+// one reading of every IME, all taken during the same control period
+struct ImeSnapshot
+{
+    // when the snapshot was taken, in ms and us
+    unsigned long time;
+    unsigned long timeMicros;
+    int counts[IME_COUNT];
+    int velocities[IME_COUNT];
+};
+
+// the latest snapshot, only the sampler writes it
+static shared::Seqlock<ImeSnapshot> snapshot;
+// counts that should be treated as zero, which saves an imeReset() call
+//  whenever we want to zero an IME
+static volatile int zeroCounts[IME_COUNT];
+
+// every motor output goes through here so it's written once per tick
+static motor::MotorFrame frame(INVERTED_PORTS);
 
-static double liftTarget = 0;
-// protects liftTarget from being accessed by two tasks at the same time
-static Mutex liftTargetMutex;
+// the lift stats the way the lift controller keeps them, getLiftStats()
+//  converts them into motor::LiftStats
+struct LiftControllerStats
+{
+    unsigned long settleTime;
+    units::LiftUnits overshoot;
+    unsigned long moves;
+};
+
+// its generation changes whenever it's set, which is how the controller
+//  knows to restart its stats
+static shared::Target liftTarget;
+// whether the lift controller is the one driving the lift
+static volatile bool liftHeld = false;
+// given by the lift controller whenever the lift settles
+static Semaphore liftSettledSemaphore;
+// generation of liftTarget that the lift is settled at, only the lift
+//  controller writes it, so a target set while it's settling can't be
+//  mistaken for settled
+#define NOT_SETTLED ((unsigned long) -1)
+static volatile unsigned long liftSettledGeneration = NOT_SETTLED;
+static shared::Seqlock<LiftControllerStats> liftStats;
+
+// what the lift controller keeps between runs, only controlLift() uses it
+struct LiftControllerState
+{
+    // the target that the stats are for
+    unsigned int generation;
+    // only the lift controller changes the stats, so it keeps its own copy
+    LiftControllerStats stats;
+    // time the current target was set
+    unsigned long start;
+    // time the lift entered the tolerance, or 0 if it isn't in it
+    unsigned long inTolerance;
+    // which way the lift had to go to get to the target
+    long direction;
+    // in motor power << LIFT_UNIT_SHIFT
+    long integral;
+};
+static LiftControllerState liftState;
 
-static double mglTarget = 0;
-static Mutex mglTargetMutex;
+static shared::Target mglTarget;
 
 // converts a Direction to an actual speed
 static int speedControl(motor::Direction direction, int up, int down)
@@ -56,13 +161,138 @@ static int speedControl(motor::Direction direction, int up, int down)
     return 0;
 }
 
+// reads every IME once and publishes it as the new snapshot, returns it
+// if all is false, only the drive train counts get read for the odometry
+static ImeSnapshot sample(bool all)
+{
+    const ImeSnapshot current = snapshot.read();
+    ImeSnapshot next;
+    for (unsigned char ime = 0; ime < IME_COUNT; ++ime)
+    {
+        bool read = all || ime == IME_LEFT || ime == IME_RIGHT;
+        // if an IME couldn't be read, just keep its last known values
+        if (!read || !imeGet(ime, &next.counts[ime]))
+        {
+            next.counts[ime] = current.counts[ime];
+        }
+        if (!all)
+        {
+            next.velocities[ime] = current.velocities[ime];
+        }
+        else if (!imeGetVelocity(ime, &next.velocities[ime]))
+        {
+            // an IME that can't be read looks stalled, so anything waiting
+            //  on it gives up instead of waiting forever
+            next.velocities[ime] = 0;
+        }
+    }
+    next.time = millis();
+    next.timeMicros = micros();
+    snapshot.write(next);
+    return next;
+}
+
+// gets the speed of an IME in whole rpm without any floating point math
+static int getWholeRpm(const ImeSnapshot& current, unsigned char ime)
+{
+    return current.velocities[ime] * 10 / (int) (RPM_DIVISOR_TORQUE * 10);
+}
+
+// tells the frame how fast each group is going for its current model, in
+//  the same direction as the group's outputs
+static void updateSpeeds(const ImeSnapshot& current)
+{
+    Lift::setSpeed(frame, -getWholeRpm(current, IME_LIFT));
+    Mgl::setSpeed(frame, -getWholeRpm(current, IME_MGL));
+    LeftDrive::setSpeed(frame, getWholeRpm(current, IME_LEFT));
+    RightDrive::setSpeed(frame, -getWholeRpm(current, IME_RIGHT));
+}
+
+// gets the counts of an IME relative to when it was last zeroed
+static int getCounts(unsigned char ime)
+{
+    return snapshot.read().counts[ime] - zeroCounts[ime];
+}
+
+// gets the velocity of an IME in output revolutions per minute
+static double getRpm(unsigned char ime)
+{
+    return snapshot.read().velocities[ime] / RPM_DIVISOR_TORQUE;
+}
+
+// gets how fast a drive train IME's wheel is going in 1/16 inches per second
+//  without any floating point math
+static long getWheelSpeed(unsigned char ime)
+{
+    static const long long factor = units::factor(2 * M_PI * WHEEL_RADIUS /
+        (60 * RPM_DIVISOR_TORQUE));
+    return units::scale(snapshot.read().velocities[ime], factor);
+}
+
+// gets how fast the lift is going up in LiftUnits per second without any
+//  floating point math
+static long getLiftSpeed()
+{
+    static const long long factor = units::factor(LIFT_UNITS_PER_COUNT *
+        COUNTS_PER_REV_TORQUE / (60 * RPM_DIVISOR_TORQUE));
+    return -units::scale(snapshot.read().velocities[IME_LIFT], factor);
+}
+
+// zeroes the lift IME at the moment the lift hit its limit switch, once for
+//  every time it's hit
+// current has to have the lift IME in it
+static void homeLift(const ImeSnapshot& current)
+{
+    // only the motor controller calls this
+    static unsigned long homedContacts = 0;
+    sensor::LiftContact contact = sensor::getLiftContact();
+    if (contact.contacts == homedContacts)
+    {
+        return;
+    }
+    homedContacts = contact.contacts;
+    // the IME wasn't read at the exact moment the switch was hit, so go back
+    //  along the lift's velocity to where it was then
+    // velocities are rpm * 39.2 and there's 627.2 counts per rev, so that's
+    //  velocity * 16 / 60000000 counts per us
+    long elapsed = (long) (current.timeMicros - contact.time);
+    zeroCounts[IME_LIFT] = current.counts[IME_LIFT] - (int)
+        ((long long) current.velocities[IME_LIFT] * elapsed / 3750000);
+}
+
+// drives the lift without touching the lift controller
+static void driveLift(int drive)
+{
+    // don't go any lower if the lift is already down
+    if (drive < 0 && sensor::isLiftDown())
+    {
+        drive = 0;
+    }
+    if (drive > 0 && motor::getLiftPosition() >=
+        units::LiftUnits((long) MAX_POS << LIFT_UNIT_SHIFT))
+    {
+        drive = 0;
+    }
+    Lift::set(frame, drive);
+}
+
 // declared in main.hpp
 
 void motor::init()
 {
-    // create mutexes
-    liftTargetMutex = mutexCreate();
-    mglTargetMutex = mutexCreate();
+    liftSettledSemaphore = semaphoreCreate();
+    Lift::setSlewRate(frame, LIFT_SLEW);
+    Mgl::setSlewRate(frame, MGL_SLEW);
+    LeftDrive::setSlewRate(frame, DRIVE_SLEW);
+    RightDrive::setSlewRate(frame, DRIVE_SLEW);
+    LeftDrive::setMotorCount(frame, DRIVE_MOTORS);
+    RightDrive::setMotorCount(frame, DRIVE_MOTORS);
+    // the controllers and motion profiles are tuned for a 7.2V battery
+    Lift::setCompensated(frame, true);
+    Mgl::setCompensated(frame, true);
+    LeftDrive::setCompensated(frame, true);
+    RightDrive::setCompensated(frame, true);
+    frame.setCurrentBudget(CURRENT_BUDGET);
     // initialize IMEs
     int imeCount = imeInitializeAll();
     if (imeCount != IME_COUNT)
@@ -78,21 +308,65 @@ void motor::init()
         imeReset(IME_LIFT);
         //print("IMEs ok!");
     }
+    // take the first sample now so the getters work before the task starts
+    sample(true);
+}
+
+void motor::sense()
+{
+    // the executor runs this every ODOM_RATE, starting on tick 0
+    bool poll = exec::getTick() % (MOTOR_POLL_RATE / ODOM_RATE) == 0;
+    const ImeSnapshot now = sample(poll);
+    if (poll)
+    {
+        homeLift(now);
+        telemetry::logImes(now.counts);
+    }
+    odom::update(now.counts[IME_LEFT], -now.counts[IME_RIGHT], now.time);
+}
+
+void motor::flush()
+{
+    updateSpeeds(snapshot.read());
+    frame.flush();
+    int outputs[PORT_COUNT];
+    for (unsigned char port = 1; port <= PORT_COUNT; ++port)
+    {
+        outputs[port - 1] = frame.getOutput(port);
+    }
+    telemetry::logMotors(outputs);
+}
+
+unsigned long motor::getSampleTime()
+{
+    return snapshot.read().time;
+}
+
+const motor::MotorFrame& motor::getFrame()
+{
+    return frame;
 }
 
 double motor::getLiftPos()
 {
-    int counts;
-    imeGet(IME_LIFT, &counts);
-    return MAX_POS / (LIFT_MAX_REVS * COUNTS_PER_REV_TORQUE) * -counts;
+    return getLiftPosition().get() / (double) (1 << LIFT_UNIT_SHIFT);
+}
+
+units::LiftUnits motor::getLiftPosition()
+{
+    return units::convert<units::LiftUnits,
+        units::factor(LIFT_UNITS_PER_COUNT)>(units::Counts(
+        -getCounts(IME_LIFT)));
+}
+
+double motor::getLiftVelocity()
+{
+    return MAX_POS / LIFT_MAX_REVS / 60 * -getRpm(IME_LIFT);
 }
 
 double motor::getLiftTarget()
 {
-    mutexTake(liftTargetMutex, -1);
-    double target = liftTarget;
-    mutexGive(liftTargetMutex);
-    return target;
+    return liftTarget.get();
 }
 
 void motor::setLiftTarget(double targetPos)
@@ -106,42 +380,170 @@ void motor::setLiftTarget(double targetPos)
     {
         targetPos = MIN_POS;
     }
-    mutexTake(liftTargetMutex, -1);
-    liftTarget = targetPos;
-    mutexGive(liftTargetMutex);
+    liftTarget.set(targetPos);
+    // the controller has to see the new target before it sees it's held
+    __sync_synchronize();
+    liftHeld = true;
+    // throw away a settle from an older target
+    semaphoreTake(liftSettledSemaphore, 0);
 }
 
 void motor::setLift(int drive)
 {
-    // don't go any lower if the lift is already down
-    if (drive < 0 && sensor::isLiftDown())
+    liftHeld = false;
+    driveLift(drive);
+}
+
+void motor::controlLift()
+{
+    unsigned long time = exec::getTime();
+    if (!liftHeld)
     {
-        drive = 0;
-        imeReset(IME_LIFT);
+        liftState.integral = 0;
+        return;
+    }
+    unsigned int targetGeneration;
+    units::LiftUnits target(liftTarget.getFixed(targetGeneration) *
+        LIFT_ONE / (1 << TARGET_SHIFT));
+    units::LiftUnits error = target - getLiftPosition();
+    long speed = getLiftSpeed();
+    if (targetGeneration != liftState.generation)
+    {
+        liftState.generation = targetGeneration;
+        liftState.start = time;
+        liftState.inTolerance = 0;
+        liftState.direction = error.get() > 0 ? 1 : -1;
+        liftState.integral = 0;
+        liftState.stats.settleTime = 0;
+        liftState.stats.overshoot = units::LiftUnits();
     }
-    if (drive > 0 && getLiftPos() >= MAX_POS)
+    // the limit switch is the real bottom, so don't try to push past it
+    bool bottom = sensor::isLiftDown() &&
+        target <= units::LiftUnits((long) MIN_POS << LIFT_UNIT_SHIFT);
+    bool near = units::abs(error) <= units::LiftUnits(LIFT_I_BAND * LIFT_ONE);
+    long drive;
+    if (bottom)
     {
+        liftState.integral = 0;
         drive = 0;
     }
-    motorSet(LIFT_BL, -drive);
-    motorSet(LIFT_TL, -drive);
-    motorSet(LIFT_BR, drive);
-    motorSet(LIFT_TR, drive);
+    else
+    {
+        // the integral only fixes what's left once the lift is almost
+        //  there, and it starts over once the lift goes past the target
+        if (!near || (error.get() > 0 && liftState.integral < 0) ||
+            (error.get() < 0 && liftState.integral > 0))
+        {
+            liftState.integral = 0;
+        }
+        drive = LIFT_KG * LIFT_ONE + error.get() * LIFT_KP +
+            liftState.integral - speed * LIFT_KD;
+        // only integrate when it wouldn't push an already maxed out
+        //  output any further (anti-windup)
+        if (near && (drive < 127 * LIFT_ONE || error.get() < 0) &&
+            (drive > -127 * LIFT_ONE || error.get() > 0))
+        {
+            liftState.integral += error.get() * LIFT_KI * MOTOR_POLL_RATE /
+                1000;
+            if (liftState.integral > LIFT_I_MAX * LIFT_ONE)
+            {
+                liftState.integral = LIFT_I_MAX * LIFT_ONE;
+            }
+            else if (liftState.integral < -LIFT_I_MAX * LIFT_ONE)
+            {
+                liftState.integral = -LIFT_I_MAX * LIFT_ONE;
+            }
+        }
+    }
+    if (drive > 127 * LIFT_ONE)
+    {
+        drive = 127 * LIFT_ONE;
+    }
+    else if (drive < -127 * LIFT_ONE)
+    {
+        drive = -127 * LIFT_ONE;
+    }
+    // dividing drops the fraction towards 0, like a cast would
+    driveLift((int) (drive / LIFT_ONE));
+    // keep track of how far the lift went past the target
+    units::LiftUnits past = -error * liftState.direction;
+    if (past > liftState.stats.overshoot)
+    {
+        liftState.stats.overshoot = past;
+    }
+    bool inside = bottom ||
+        (units::abs(error) <= units::LiftUnits(LIFT_TOLERANCE * LIFT_ONE) &&
+        labs(speed) <= LIFT_SETTLE_SPEED * LIFT_ONE);
+    if (!inside)
+    {
+        liftState.inTolerance = 0;
+    }
+    else if (liftState.inTolerance == 0)
+    {
+        liftState.inTolerance = time;
+    }
+    bool settled = liftSettledGeneration == liftState.generation;
+    if (inside && !settled && time - liftState.inTolerance >= LIFT_SETTLE_TIME)
+    {
+        liftState.stats.settleTime = time - liftState.start;
+        ++liftState.stats.moves;
+        liftSettledGeneration = liftState.generation;
+        semaphoreGive(liftSettledSemaphore);
+    }
+    else if (!inside && settled)
+    {
+        // got knocked out of the tolerance after settling
+        liftSettledGeneration = NOT_SETTLED;
+    }
+    liftStats.write(liftState.stats);
+}
+
+bool motor::isLiftSettled()
+{
+    return liftSettledGeneration == liftTarget.getGeneration();
+}
+
+bool motor::waitForLift(unsigned long timeout)
+{
+    unsigned long start = millis();
+    // the semaphore might've been given for an older target, so check again
+    //  every time it's taken
+    while (!isLiftSettled())
+    {
+        unsigned long waited = millis() - start;
+        if (waited >= timeout ||
+            !semaphoreTake(liftSettledSemaphore, timeout - waited))
+        {
+            return isLiftSettled();
+        }
+    }
+    return true;
+}
+
+motor::LiftStats motor::getLiftStats()
+{
+    LiftControllerStats kept = liftStats.read();
+    motor::LiftStats stats;
+    stats.settleTime = kept.settleTime;
+    stats.overshoot = kept.overshoot.get() / (double) LIFT_ONE;
+    stats.moves = kept.moves;
+    return stats;
 }
 
 double motor::getMglPos()
 {
-    int counts;
-    imeGet(IME_MGL, &counts);
-    return MAX_POS / (MGL_MAX_REVS * COUNTS_PER_REV_TORQUE) * -counts;
+    return MAX_POS / (MGL_MAX_REVS * COUNTS_PER_REV_TORQUE) *
+        -getCounts(IME_MGL);
+}
+
+double motor::getMglVelocity()
+{
+    return MAX_POS / MGL_MAX_REVS / 60 * -getRpm(IME_MGL);
 }
 
 double motor::getMglTarget()
 {
-    mutexTake(mglTargetMutex, -1);
-    double target = mglTarget;
-    mutexGive(mglTargetMutex);
-    return target;
+    return mglTarget.get();
 }
 
 void motor::setMglTarget(double targetPos)
@@ -155,57 +557,64 @@ void motor::setMglTarget(double targetPos)
     {
         targetPos = MIN_POS;
     }
-    mutexTake(mglTargetMutex, -1);
-    mglTarget = targetPos;
-    mutexGive(mglTargetMutex);
+    mglTarget.set(targetPos);
 }
 
 void motor::setMgl(int drive)
 {
-    motorSet(MGL_LEFT, drive);
-    motorSet(MGL_RIGHT, -drive);
+    Mgl::set(frame, drive);
+}
+
+units::Counts motor::getLeftCounts()
+{
+    return units::Counts(getCounts(IME_LEFT));
+}
+
+units::Counts motor::getRightCounts()
+{
+    return units::Counts(-getCounts(IME_RIGHT));
+}
+
+double motor::getLeftVelocity()
+{
+    return getRpm(IME_LEFT) / 60;
 }
 
-double motor::getLeftRotations()
+double motor::getRightVelocity()
 {
-    int counts;
-    imeGet(IME_LEFT, &counts);
-    return counts / COUNTS_PER_REV_TORQUE;
+    return -getRpm(IME_RIGHT) / 60;
 }
 
-double motor::getRightRotations()
+long motor::getLeftSpeed()
 {
-    int counts;
-    imeGet(IME_RIGHT, &counts);
-    return -counts / COUNTS_PER_REV_TORQUE;
+    return getWheelSpeed(IME_LEFT);
 }
 
-void motor::resetDT()
+long motor::getRightSpeed()
 {
-    imeReset(IME_LEFT);
-    imeReset(IME_RIGHT);
+    return -getWheelSpeed(IME_RIGHT);
 }
 
 void motor::setLeftDriveTrain(int speed)
 {
-    motorSet(DRIVE_LEFT, speed);
+    LeftDrive::set(frame, speed);
 }
 
 void motor::setRightDriveTrain(int speed)
 {
-    motorSet(DRIVE_RIGHT, -speed);
+    RightDrive::set(frame, speed);
 }
 
 void motor::setClaw(Direction direction)
 {
     int speed = speedControl(direction, CLAW_SPEED, -CLAW_SPEED);
-    motorSet(CLAW, speed);
+    Claw::set(frame, speed);
 }
 
 void motor::setTwistyBoi(Direction direction)
 {
     int speed = speedControl(direction, TB_SPEED, -TB_SPEED);
-    motorSet(TWISTY_BOI, speed);
+    TwistyBoi::set(frame, speed);
 }
 
 void motor::setMobileGoalLift(Direction direction)
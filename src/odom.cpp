@@ -0,0 +1,187 @@
+// keeps track of where the robot is on the field using the drive train IMEs
+//  and the gyro
+// everything in here is fixed point since the cortex doesn't have an FPU
+
+#include "main.hpp"
+
+// distance one IME count moves a wheel, in 1/16 inches << POSE_SHIFT
+#define DIST_PER_COUNT ((long) (2 * M_PI * WHEEL_RADIUS * (1 << POSE_SHIFT) / \
+    COUNTS_PER_REV_TORQUE + 0.5))
+// how much the heading changes when one side goes one count more than the
+//  other, in HEADING_PER_REV units
+#define HEADING_PER_COUNT ((long) ((double) WHEEL_RADIUS * HEADING_PER_REV / \
+    (COUNTS_PER_REV_TORQUE * 2 * BOT_RADIUS) + 0.5))
+
+// the IMEs' heading is smooth but drifts whenever a wheel slips, and the
+//  gyro doesn't drift but only changes in steps, so every update takes out
+//  1/(1 << GYRO_FILTER_SHIFT) of the difference between them
+#define GYRO_FILTER_SHIFT 4
+// an empty gyro port still initializes, it just never turns, so the gyro
+//  only gets listened to once it's turned along with the wheels
+// only updates where the sides go opposite ways count, since one side
+//  slipping can look like a turn but can't make a wheel go backwards
+// once the wheels have spun this far, the gyro has to have gone at least
+//  1/GYRO_CHECK_RATIO as far the same way or it gets ignored for good
+#define GYRO_CHECK_TURN (HEADING_PER_REV / 24)
+#define GYRO_CHECK_RATIO 2
+
+// sin(x) for a quarter of a rotation in 64 steps, << 14
+static const short sinTable[65] =
+{
+    0, 402, 804, 1205, 1606, 2006, 2404, 2801,
+    3196, 3590, 3981, 4370, 4756, 5139, 5520, 5897,
+    6270, 6639, 7005, 7366, 7723, 8076, 8423, 8765,
+    9102, 9434, 9760, 10080, 10394, 10702, 11003, 11297,
+    11585, 11866, 12140, 12406, 12665, 12916, 13160, 13395,
+    13623, 13842, 14053, 14256, 14449, 14635, 14811, 14978,
+    15137, 15286, 15426, 15557, 15679, 15791, 15893, 15986,
+    16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379,
+    16384
+};
+
+// the pose that update() works on
+static odom::Pose current = {0, 0, 0, 0};
+// counts from the last update, so only the changes get integrated
+static int lastLeft;
+static int lastRight;
+static bool started = false;
+// setPose() hands the new pose over to update() so only one task writes it
+static odom::Pose requestedPose;
+static volatile bool poseRequested = false;
+// what to add to the gyro's heading to get the odometry's
+static long gyroOffset = 0;
+// whether the gyro has been checked, see GYRO_CHECK_TURN
+enum GyroState
+{
+    GYRO_UNCHECKED,
+    GYRO_TRUSTED,
+    GYRO_IGNORED
+};
+static GyroState gyroState = GYRO_UNCHECKED;
+// how far the wheels have spun and the gyro's heading when checking started
+static long checkSpin = 0;
+static long checkStart;
+
+// what getPose() reads, only update() writes it
+static shared::Seqlock<odom::Pose> published;
+
+// checks the gyro against how far the wheels spun this update, returns
+//  whether it can be listened to
+static bool checkGyro(long dLeft, long dRight, long dHeading)
+{
+    if (gyroState != GYRO_UNCHECKED)
+    {
+        return gyroState == GYRO_TRUSTED;
+    }
+    if ((dLeft < 0 && dRight > 0) || (dLeft > 0 && dRight < 0))
+    {
+        checkSpin += dHeading;
+    }
+    if (labs(checkSpin) < GYRO_CHECK_TURN)
+    {
+        return false;
+    }
+    long turned = sensor::getGyroHeading() - checkStart;
+    if (checkSpin < 0)
+    {
+        turned = -turned;
+    }
+    gyroState = turned >= labs(checkSpin) / GYRO_CHECK_RATIO ? GYRO_TRUSTED :
+        GYRO_IGNORED;
+    return gyroState == GYRO_TRUSTED;
+}
+
+// declared in main.hpp
+
+void odom::update(int left, int right, unsigned long time)
+{
+    if (!started)
+    {
+        lastLeft = left;
+        lastRight = right;
+        started = true;
+        if (sensor::hasGyro())
+        {
+            checkStart = sensor::getGyroHeading();
+        }
+    }
+    if (poseRequested)
+    {
+        current = requestedPose;
+        poseRequested = false;
+        if (sensor::hasGyro())
+        {
+            gyroOffset = current.heading - sensor::getGyroHeading();
+        }
+    }
+    long dLeft = left - lastLeft;
+    long dRight = right - lastRight;
+    lastLeft = left;
+    lastRight = right;
+    long dHeading = (dRight - dLeft) * HEADING_PER_COUNT;
+    long distance = (dLeft + dRight) * DIST_PER_COUNT / 2;
+    // move along the average heading over this update
+    unsigned long middle = (current.heading + dHeading / 2) >>
+        (HEADING_SHIFT - 16);
+    current.x += ((long long) distance * sin16(middle + 0x4000)) >> 14;
+    current.y += ((long long) distance * sin16(middle)) >> 14;
+    current.heading += dHeading;
+    if (sensor::hasGyro() && checkGyro(dLeft, dRight, dHeading))
+    {
+        long error = sensor::getGyroHeading() + gyroOffset - current.heading;
+        current.heading += error >> GYRO_FILTER_SHIFT;
+    }
+    current.time = time;
+    published.write(current);
+}
+
+odom::Pose odom::getPose()
+{
+    return published.read();
+}
+
+bool odom::isGyroTrusted()
+{
+    return gyroState == GYRO_TRUSTED;
+}
+
+void odom::setPose(const Pose& pose)
+{
+    requestedPose = pose;
+    __sync_synchronize();
+    poseRequested = true;
+    // update() takes it on its next run
+    while (poseRequested)
+    {
+        taskDelay(1);
+    }
+}
+
+long odom::sin16(unsigned long angle)
+{
+    unsigned long quadrant = (angle >> 14) & 3;
+    unsigned long index = angle & 0x3fff;
+    // the table only has the first quadrant, so mirror it for the others
+    if (quadrant & 1)
+    {
+        index = 0x4000 - index;
+    }
+    unsigned long step = index >> 8;
+    long value = sinTable[step];
+    if (step < 64)
+    {
+        // linearly interpolate between table entries
+        value += ((sinTable[step + 1] - value) * (long) (index & 0xff)) >> 8;
+    }
+    return quadrant & 2 ? -value : value;
+}
+
+long odom::toSixteenths(long position)
+{
+    return position >> POSE_SHIFT;
+}
+
+long odom::toDegrees(long heading)
+{
+    return (long) (((long long) heading * 360) >> HEADING_SHIFT);
+}
@@ -10,17 +10,45 @@
 // used in the threshold function to prevent joystick ghosting
 #define THRESHOLD 4
 
-// these functions get and respond to driver input for every different part
+// where update() gets its input from
+enum Source
+{
+    NOBODY,
+    JOYSTICK,
+    PLAYBACK
+};
+
+// set by operatorControl() and replay(), and set back to NOBODY by update()
+//  once a recording is over
+static volatile Source source = NOBODY;
+// given by update() when a recording is over
+static Semaphore replayDone;
+#ifdef AUTON_DEBUG
+// given by update() when the driver wants to run autonomous, which can't
+//  be done in the executor
+static Semaphore autonRequested;
+#endif // AUTON_DEBUG
+
+// reads everything the driver controls use from the joystick, all at once
+static input::State poll();
+
+// these functions respond to driver input for every different part
 // operatorControl() should be calling these functions in the order below
-static void controlDriveTrain();
-static void controlLift();
-static void controlClaw();
-static void controlTwistyBoi();
-static void controlMobileGoalLift();
+static void controlDriveTrain(const input::State& state);
+static void controlLift(const input::State& state);
+static void controlClaw(const input::State& state);
+static void controlTwistyBoi(const input::State& state);
+static void controlMobileGoalLift(const input::State& state);
+// starts/stops recording the driver when 7 up is pressed
+static void controlRecording(const input::State& state,
+    const input::State& previous);
 #ifdef AUTON_DEBUG
-static void controlAutonomous();
+static void controlAutonomous(const input::State& state);
 #endif // AUTON_DEBUG
 
+// calls all the control functions above
+static void control(const input::State& state);
+
 // returns what was given if the value exceeds the threshold, else 0 to prevent
 //  joystick ghosting
 static int threshold(int value);
@@ -29,49 +57,145 @@ static int threshold(int value);
 static motor::Direction direction(bool up, bool down);
 
 // main point of execution for the driver control period
+// input::update() in the executor does the actual driving, so this only
+//  tells it to and then waits around for anything it can't do
 void operatorControl()
 {
-    // keeps track of the current time since the last opcontrol loop
-    unsigned long time = millis();
-    // goes into an infinite loop, constantly receiving and responding to input
-    while (1)
+    telemetry::start(TELEMETRY_DRIVER_FILE);
+    source = JOYSTICK;
+#ifdef AUTON_DEBUG
+    // semaphores start out given
+    semaphoreTake(autonRequested, 0);
+    while (semaphoreTake(autonRequested, -1))
     {
-        controlDriveTrain();
-        controlLift();
-        controlClaw();
-        controlTwistyBoi();
-        controlMobileGoalLift();
+        // autonomous() drives the robot itself
+        autonomous();
+        source = JOYSTICK;
+    }
+#endif // AUTON_DEBUG
+    // there's nothing else for this task to do
+    taskSuspend(NULL);
+}
+
+// declared in main.hpp
+
+void input::init()
+{
+    replayDone = semaphoreCreate();
 #ifdef AUTON_DEBUG
-        controlAutonomous();
+    autonRequested = semaphoreCreate();
+#endif // AUTON_DEBUG
+}
+
+void input::update()
+{
+    // used for the button edges, only the executor touches it
+    static State previous;
+    if (source == JOYSTICK)
+    {
+        // the field takes over during autonomous, and nothing gets driven
+        //  while disabled
+        if (isAutonomous() || !isEnabled())
+        {
+            return;
+        }
+        State state = poll();
+        telemetry::logJoystick(state);
+        controlRecording(state, previous);
+        record(state);
+        control(state);
+#ifdef AUTON_DEBUG
+        controlAutonomous(state);
 #endif
-        // wait a bit before receiving input again
-        taskDelayUntil(&time, MOTOR_POLL_RATE);
+        previous = state;
+    }
+    else if (source == PLAYBACK)
+    {
+        State state;
+        // stop when the recording ends or autonomous gets cut off
+        if (play(&state))
+        {
+            control(state);
+            return;
+        }
+        // don't leave anything running
+        control(State());
+        source = NOBODY;
+        semaphoreGive(replayDone);
     }
 }
 
-void controlDriveTrain()
+void input::replay()
+{
+    if (!startPlayback())
+    {
+        return;
+    }
+    // update() plays it back, this only waits for it to be over
+    semaphoreTake(replayDone, 0);
+    source = PLAYBACK;
+    semaphoreTake(replayDone, -1);
+    stopPlayback();
+}
+
+input::State poll()
+{
+    input::State state;
+    for (unsigned char axis = 0; axis < AXIS_COUNT; ++axis)
+    {
+        state.axes[axis] = threshold(joystickGetAnalog(1, axis + 1));
+    }
+    state.buttons = 0;
+    // same order as input::Button
+    static const unsigned char groups[input::BUTTON_COUNT] =
+    {
+        5, 5, 6, 6, 7, 7, 8, 8, 8, 8
+    };
+    static const unsigned char buttons[input::BUTTON_COUNT] =
+    {
+        JOY_UP, JOY_DOWN, JOY_UP, JOY_DOWN, JOY_LEFT, JOY_UP, JOY_UP, JOY_DOWN,
+        JOY_LEFT, JOY_RIGHT
+    };
+    for (unsigned int i = 0; i < input::BUTTON_COUNT; ++i)
+    {
+        if (joystickGetDigital(1, groups[i], buttons[i]))
+        {
+            state.buttons |= 1u << i;
+        }
+    }
+    return state;
+}
+
+void control(const input::State& state)
+{
+    controlDriveTrain(state);
+    controlLift(state);
+    controlClaw(state);
+    controlTwistyBoi(state);
+    controlMobileGoalLift(state);
+}
+
+void controlDriveTrain(const input::State& state)
 {
     // gather joystick input
 #ifdef TANK_CONTROLS
     // tank controls
-    int left = threshold(joystickGetAnalog(1, 3));
-    int right = threshold(joystickGetAnalog(1, 2));
+    int left = state.axes[2];
+    int right = state.axes[1];
 #else
     // arcade controls
-    int left = threshold(joystickGetAnalog(1, 3)) +
-        threshold(joystickGetAnalog(1, 1));
-    int right = threshold(joystickGetAnalog(1, 3)) -
-        threshold(joystickGetAnalog(1, 1));
+    int left = state.axes[2] + state.axes[0];
+    int right = state.axes[2] - state.axes[0];
 #endif
     // set the drive train motors accordingly
     motor::setLeftDriveTrain(left);
     motor::setRightDriveTrain(right);
 }
 
-void controlLift()
+void controlLift(const input::State& state)
 {
-    bool liftUp = joystickGetDigital(1, 6, JOY_UP);
-    bool liftDown = joystickGetDigital(1, 6, JOY_DOWN);
+    bool liftUp = state.pressed(input::BTN_6U);
+    bool liftDown = state.pressed(input::BTN_6D);
     if (liftUp && !liftDown)
     {
         motor::setLift(127);
@@ -86,33 +210,51 @@ void controlLift()
     }
 }
 
-void controlClaw()
+void controlClaw(const input::State& state)
 {
-    bool clawClose = joystickGetDigital(1, 5, JOY_UP);
-    bool clawOpen = joystickGetDigital(1, 5, JOY_DOWN);
+    bool clawClose = state.pressed(input::BTN_5U);
+    bool clawOpen = state.pressed(input::BTN_5D);
     motor::setClaw(direction(clawClose, clawOpen));
 }
 
-void controlTwistyBoi()
+void controlTwistyBoi(const input::State& state)
 {
-    bool forward = joystickGetDigital(1, 8, JOY_LEFT);
-    bool backward = joystickGetDigital(1, 8, JOY_RIGHT);
+    bool forward = state.pressed(input::BTN_8L);
+    bool backward = state.pressed(input::BTN_8R);
     motor::setTwistyBoi(direction(forward, backward));
 }
 
-void controlMobileGoalLift()
+void controlMobileGoalLift(const input::State& state)
 {
-    bool mglUp = joystickGetDigital(1, 8, JOY_UP);
-    bool mglDown = joystickGetDigital(1, 8, JOY_DOWN);
+    bool mglUp = state.pressed(input::BTN_8U);
+    bool mglDown = state.pressed(input::BTN_8D);
     motor::setMobileGoalLift(direction(mglUp, mglDown));
 }
 
+void controlRecording(const input::State& state, const input::State& previous)
+{
+    if (state.pressed(input::BTN_7U) && !previous.pressed(input::BTN_7U))
+    {
+        if (input::isRecording())
+        {
+            input::stopRecording();
+        }
+        else
+        {
+            input::startRecording();
+        }
+    }
+}
+
 #ifdef AUTON_DEBUG
-void controlAutonomous()
+void controlAutonomous(const input::State& state)
 {
-    if (joystickGetDigital(1, 7, JOY_LEFT))
+    if (state.pressed(input::BTN_7L))
     {
-        autonomous();
+        // operatorControl() runs it, and update() won't call this again
+        //  until it's over
+        source = NOBODY;
+        semaphoreGive(autonRequested);
     }
 }
 #endif // AUTON_DEBUG
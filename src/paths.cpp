@@ -0,0 +1,35 @@
+// contains the paths from tools/paths.txt, generated by tools/pathc
+// don't edit this, edit tools/paths.txt and run make in tools/ instead
+
+#include "main.hpp"
+
+// mgzone
+static const path::Point path0[] =
+{
+    {-500, 0, 300}, {-484, 0, 300}, {-468, 0, 300}, {-452, 0, 300},
+    {-436, 0, 300}, {-420, 0, 300}, {-404, 0, 300}, {-388, 0, 300},
+    {-372, 0, 300}, {-356, 0, 300}, {-340, 0, 300}, {-324, 0, 300},
+    {-308, 0, 300}, {-292, 0, 300}, {-276, 0, 300}, {-260, 0, 300},
+    {-244, 0, 300}, {-228, 0, 300}, {-212, 0, 300}, {-196, 0, 300},
+    {-180, 0, 300}, {-164, 0, 300}, {-148, 0, 300}, {-132, 0, 300},
+    {-116, 0, 300}, {-100, 0, 300}, {-84, 0, 300}, {-68, 0, 300},
+    {-52, 0, 300}, {-36, 0, 300}, {-20, 0, 300}, {-4, 0, 300},
+    {12, 0, 300}, {28, 0, 300}, {44, 0, 300}, {60, 0, 300},
+    {76, 0, 300}, {92, 0, 300}, {108, 0, 300}, {124, 0, 300},
+    {140, 0, 300}, {156, 0, 288}, {172, 0, 288}, {188, 2, 288},
+    {204, 5, 288}, {219, 9, 288}, {234, 15, 288}, {249, 21, 288},
+    {262, 29, 288}, {276, 38, 288}, {288, 49, 288}, {300, 60, 300},
+    {311, 71, 300}, {322, 82, 300}, {334, 94, 300}, {345, 105, 300},
+    {356, 116, 300}, {367, 127, 300}, {379, 139, 300}, {390, 150, 300},
+    {401, 161, 300}, {413, 173, 300}, {424, 184, 300}, {435, 195, 300},
+    {447, 207, 300}, {458, 218, 300}, {469, 229, 300}, {481, 241, 300},
+    {492, 252, 300}, {503, 263, 300}, {515, 275, 300}, {526, 286, 300},
+    {537, 297, 300}, {548, 308, 300}, {560, 320, 268}, {571, 331, 229},
+    {582, 342, 182}, {594, 354, 118}, {602, 362, 0}
+};
+
+const path::Path path::paths[] =
+{
+    {"mgzone", path0, sizeof(path0) / sizeof(path0[0])},
+};
+const unsigned int path::pathCount = 1;
@@ -0,0 +1,164 @@
+// defines the motion profile generator used by autonomous
+
+#include "main.hpp"
+
+// amount of times to halve the search range when finding the peak velocity
+#define PEAK_ITERATIONS 24
+// planning is done in doubles once per move, the segments it comes up with
+//  are kept in fixed point so at() doesn't need any floating point math
+#define ONE (1l << PROFILE_SHIFT)
+// at() works in 1/(1 << TIME_SHIFT)ths of a second, so the powers of time
+//  can be shifted out instead of divided out (the cortex has no 64 bit divide)
+#define TIME_SHIFT 10
+
+// converts a planned value into the fixed point the segments are kept in
+static long toFixed(double value)
+{
+    return (long) floor(value * ONE + 0.5);
+}
+
+// converts a fixed point value back into whole units, rounding to nearest
+static long toWhole(long long value)
+{
+    return (long) ((value + ONE / 2) >> PROFILE_SHIFT);
+}
+
+// finds how long it takes to get from rest to a velocity, and how long the
+//  jerk phases in that take
+static double accelTime(double velocity, const profile::Limits& limits,
+    double* jerkTime)
+{
+    if (limits.jerk <= 0)
+    {
+        // trapezoidal, so acceleration changes instantly
+        *jerkTime = 0;
+        return velocity / limits.acceleration;
+    }
+    if (velocity * limits.jerk >= limits.acceleration * limits.acceleration)
+    {
+        // there's enough time to reach max acceleration
+        *jerkTime = limits.acceleration / limits.jerk;
+        return velocity / limits.acceleration + *jerkTime;
+    }
+    // never reaches max acceleration
+    *jerkTime = sqrt(velocity / limits.jerk);
+    return 2 * *jerkTime;
+}
+
+// declared in main.hpp
+
+profile::Profile::Profile(): direction(1), distance(0), duration(0)
+{
+    for (int i = 0; i < SEGMENT_COUNT; ++i)
+    {
+        segments[i].start = 0;
+        segments[i].position = 0;
+        segments[i].velocity = 0;
+        segments[i].halfAcceleration = 0;
+        segments[i].sixthJerk = 0;
+    }
+}
+
+void profile::Profile::plan(double distance, const Limits& limits)
+{
+    direction = distance < 0 ? -1 : 1;
+    this->distance = (long) floor(distance + 0.5);
+    distance = fabs(distance);
+    // speeding up and slowing down are symmetric, and the average velocity
+    //  while doing either of them is half the peak velocity
+    double peak = limits.velocity;
+    double jerkTime;
+    double rampTime = accelTime(peak, limits, &jerkTime);
+    if (peak * rampTime > distance)
+    {
+        // too short to reach max velocity, so search for the fastest peak
+        //  velocity that still fits in the distance
+        double low = 0;
+        double high = peak;
+        for (int i = 0; i < PEAK_ITERATIONS; ++i)
+        {
+            peak = (low + high) / 2;
+            if (peak * accelTime(peak, limits, &jerkTime) > distance)
+            {
+                high = peak;
+            }
+            else
+            {
+                low = peak;
+            }
+        }
+        peak = low;
+        rampTime = accelTime(peak, limits, &jerkTime);
+    }
+    double cruiseTime = peak > 0 ? (distance - peak * rampTime) / peak : 0;
+    double constTime = rampTime - 2 * jerkTime;
+    double maxAccel = jerkTime > 0 ? limits.jerk * jerkTime :
+        limits.acceleration;
+    double jerk = jerkTime > 0 ? limits.jerk : 0;
+    // describe each segment, then integrate to get where each one starts
+    const double lengths[SEGMENT_COUNT] =
+    {
+        jerkTime, constTime, jerkTime, cruiseTime, jerkTime, constTime, jerkTime
+    };
+    const double accels[SEGMENT_COUNT] =
+    {
+        0, maxAccel, maxAccel, 0, 0, -maxAccel, -maxAccel
+    };
+    const double jerks[SEGMENT_COUNT] = { jerk, 0, -jerk, 0, -jerk, 0, jerk };
+    double t = 0;
+    double pos = 0;
+    double vel = 0;
+    for (int i = 0; i < SEGMENT_COUNT; ++i)
+    {
+        Segment& segment = segments[i];
+        segment.start = (unsigned long) (t * 1000 + 0.5);
+        segment.position = toFixed(pos);
+        segment.velocity = toFixed(vel);
+        segment.halfAcceleration = toFixed(accels[i] / 2);
+        segment.sixthJerk = toFixed(jerks[i] / 6);
+        double dt = lengths[i];
+        pos += vel * dt + accels[i] * dt * dt / 2 + jerks[i] * dt * dt * dt / 6;
+        vel += accels[i] * dt + jerks[i] * dt * dt / 2;
+        t += dt;
+    }
+    duration = (unsigned long) (t * 1000 + 0.5);
+}
+
+profile::Setpoint profile::Profile::at(unsigned long time) const
+{
+    Setpoint setpoint;
+    if (time >= duration)
+    {
+        // done, so it should be sitting still right at the end
+        setpoint.position = distance;
+        setpoint.velocity = 0;
+        setpoint.acceleration = 0;
+        return setpoint;
+    }
+    // find the segment the time is in
+    int i = SEGMENT_COUNT - 1;
+    while (i > 0 && segments[i].start > time)
+    {
+        --i;
+    }
+    const Segment& segment = segments[i];
+    long long dt = (long) (time - segment.start) * (1 << TIME_SHIFT) / 1000;
+    long long a = segment.halfAcceleration;
+    long long j = segment.sixthJerk;
+    long long position = segment.position +
+        ((segment.velocity * dt) >> TIME_SHIFT) +
+        ((a * dt * dt) >> (2 * TIME_SHIFT)) +
+        ((j * dt * dt * dt) >> (3 * TIME_SHIFT));
+    long long velocity = segment.velocity + ((2 * a * dt) >> TIME_SHIFT) +
+        ((3 * j * dt * dt) >> (2 * TIME_SHIFT));
+    long long acceleration = 2 * a + ((6 * j * dt) >> TIME_SHIFT);
+    setpoint.position = direction * toWhole(position);
+    setpoint.velocity = direction * toWhole(velocity);
+    setpoint.acceleration = direction * toWhole(acceleration);
+    return setpoint;
+}
+
+unsigned long profile::Profile::getDuration() const
+{
+    return duration;
+}
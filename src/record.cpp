@@ -0,0 +1,414 @@
+// records what the driver does with the joystick and plays it back
+//
+// a recording is a stream of records, one for each change in the joystick:
+//  - a header byte below 0x80 has a bit set for each field that changed (bits
+//    0-2 for the axes, bit 3 for the buttons), followed by the new value of
+//    each axis that changed (1 byte each), then the buttons that flipped
+//    (2 bytes, xor'd with the last buttons)
+//  - a header byte of 0x80 or above means the last state repeats for
+//    (header & 0x7f) + 1 more ticks
+
+#include "main.hpp"
+
+// size of the buffer between the control loop and the file system, has to be
+//  a power of 2
+#define RING_SIZE 512u
+// amount of bytes read or written at a time
+#define CHUNK_SIZE 128u
+// how often the streamer checks on the buffer in milliseconds
+#define STREAM_RATE MOTOR_POLL_RATE
+// header bits
+#define BUTTONS_CHANGED 0x08
+#define REPEAT 0x80
+#define MAX_REPEAT 0x80
+
+enum Mode
+{
+    IDLE,
+    // startRecording() was called, and the streamer still has to open the
+    //  file, ticks go in the ring in the meantime
+    OPENING,
+    RECORDING,
+    PLAYING
+};
+
+static volatile Mode mode = IDLE;
+// set by stopRecording() or stopPlayback() so the streamer closes the file
+//  once it's done with it, which it acknowledges by going back to IDLE
+static volatile bool stopRequested = false;
+static FILE* file = NULL;
+
+// bytes go in at head and come out at tail, which is safe without locking
+//  since only one task moves each of them
+static unsigned char ring[RING_SIZE];
+static volatile unsigned long head = 0;
+static volatile unsigned long tail = 0;
+// set once the streamer hits the end of the file
+static volatile bool ended = false;
+
+// the last state that was recorded or played
+static input::State last;
+// amount of ticks the last state has repeated but hasn't been written yet
+//  when recording, or is left to repeat when playing
+static unsigned int repeats = 0;
+
+static input::StreamStats stats;
+static timing::LoopTimer streamTimer("stream", STREAM_RATE);
+
+static unsigned long used()
+{
+    return head - tail;
+}
+
+// adds a byte to the ring, which the control loop uses when recording
+static void put(unsigned char byte)
+{
+    if (used() >= RING_SIZE)
+    {
+        ++stats.dropped;
+        return;
+    }
+    ring[head % RING_SIZE] = byte;
+    __sync_synchronize();
+    ++head;
+    ++stats.bytes;
+}
+
+// gets a byte from the ring that's been checked to be there
+static unsigned char peek(unsigned long offset)
+{
+    return ring[(tail + offset) % RING_SIZE];
+}
+
+// writes out the repeats that haven't been written yet
+static void putRepeats()
+{
+    while (repeats > 0)
+    {
+        unsigned int count = repeats < MAX_REPEAT ? repeats : MAX_REPEAT;
+        put(REPEAT | (count - 1));
+        repeats -= count;
+    }
+}
+
+// gets how many bytes a record takes from its header
+static unsigned long recordSize(unsigned char header)
+{
+    if (header & REPEAT)
+    {
+        return 1;
+    }
+    unsigned long size = 1;
+    for (unsigned int axis = 0; axis < AXIS_COUNT; ++axis)
+    {
+        size += (header >> axis) & 1;
+    }
+    return header & BUTTONS_CHANGED ? size + 2 : size;
+}
+
+// keeps the ring as full as possible when playing, until playback is stopped
+static void fill()
+{
+    while (!ended && !stopRequested && RING_SIZE - used() >= CHUNK_SIZE)
+    {
+        unsigned char chunk[CHUNK_SIZE];
+        unsigned long start = micros();
+        size_t count = fread(chunk, 1, CHUNK_SIZE, file);
+        unsigned long took = micros() - start;
+        if (took > stats.maxReadTime)
+        {
+            stats.maxReadTime = took;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            ring[(head + i) % RING_SIZE] = chunk[i];
+        }
+        __sync_synchronize();
+        head += count;
+        if (count < CHUNK_SIZE)
+        {
+            ended = true;
+        }
+    }
+}
+
+// moves data between the ring and the file
+static void stream()
+{
+    if (mode == OPENING)
+    {
+        // the file gets opened here so the control loop never waits on it
+        file = fopen(RECORD_FILE, "w");
+        if (file == NULL)
+        {
+            printf("couldn't open " RECORD_FILE " to record to\n");
+            stopRequested = false;
+            mode = IDLE;
+            return;
+        }
+        mode = RECORDING;
+    }
+    if (mode == RECORDING)
+    {
+        // write out everything that's ready, in as few writes as possible
+        while (used() > 0)
+        {
+            unsigned long start = tail % RING_SIZE;
+            unsigned long count = used();
+            if (start + count > RING_SIZE)
+            {
+                count = RING_SIZE - start;
+            }
+            fwrite(&ring[start], 1, count, file);
+            __sync_synchronize();
+            tail += count;
+        }
+        if (stopRequested)
+        {
+            fclose(file);
+            file = NULL;
+            printf("recorded %lu ticks in %lu bytes (%lu B/s, budget %d B/s), "
+                "%lu dropped\n", stats.ticks, stats.bytes, stats.ticks ?
+                stats.bytes * 1000 / (stats.ticks * MOTOR_POLL_RATE) : 0,
+                RECORD_BUDGET, stats.dropped);
+            mode = IDLE;
+            stopRequested = false;
+        }
+    }
+    else if (mode == PLAYING)
+    {
+        fill();
+        // fill() gives up as soon as it sees the request, so nothing else is
+        //  using the file by now
+        if (stopRequested)
+        {
+            fclose(file);
+            file = NULL;
+            mode = IDLE;
+            stopRequested = false;
+        }
+    }
+}
+
+// resets everything for a new recording/playback
+static void reset()
+{
+    head = 0;
+    tail = 0;
+    ended = false;
+    repeats = 0;
+    last = input::State();
+    stats = input::StreamStats();
+}
+
+// declared in main.hpp
+
+void input::streamer(void*)
+{
+    // used for timing cyclic delays
+    unsigned long time = millis();
+    while (true)
+    {
+        streamTimer.start();
+        stream();
+        streamTimer.stop();
+        taskDelayUntil(&time, STREAM_RATE);
+    }
+}
+
+bool input::startRecording()
+{
+    if (mode != IDLE)
+    {
+        return false;
+    }
+    reset();
+    stopRequested = false;
+    __sync_synchronize();
+    mode = OPENING;
+    return true;
+}
+
+void input::stopRecording()
+{
+    if (!isRecording())
+    {
+        return;
+    }
+    putRepeats();
+    __sync_synchronize();
+    stopRequested = true;
+}
+
+bool input::isRecording()
+{
+    return (mode == OPENING || mode == RECORDING) && !stopRequested;
+}
+
+void input::record(const State& state)
+{
+    if (!isRecording())
+    {
+        return;
+    }
+    ++stats.ticks;
+    unsigned char header = 0;
+    for (unsigned int axis = 0; axis < AXIS_COUNT; ++axis)
+    {
+        if (state.axes[axis] != last.axes[axis])
+        {
+            header |= 1 << axis;
+        }
+    }
+    unsigned short flipped = state.buttons ^ last.buttons;
+    if (flipped)
+    {
+        header |= BUTTONS_CHANGED;
+    }
+    if (header == 0)
+    {
+        // nothing changed, so just count it
+        ++repeats;
+    }
+    else
+    {
+        putRepeats();
+        put(header);
+        for (unsigned int axis = 0; axis < AXIS_COUNT; ++axis)
+        {
+            if (header & (1 << axis))
+            {
+                put((unsigned char) state.axes[axis]);
+            }
+        }
+        if (flipped)
+        {
+            put(flipped & 0xff);
+            put(flipped >> 8);
+        }
+        last = state;
+    }
+    if (stats.bytes >= RECORD_MAX_SIZE)
+    {
+        stopRecording();
+    }
+}
+
+bool input::startPlayback()
+{
+    if (mode != IDLE)
+    {
+        return false;
+    }
+    file = fopen(RECORD_FILE, "r");
+    if (file == NULL)
+    {
+        return false;
+    }
+    reset();
+    stopRequested = false;
+    // fill the ring up front so playback doesn't start out waiting, before
+    //  the streamer starts filling it too
+    fill();
+    mode = PLAYING;
+    return true;
+}
+
+bool input::play(State* state)
+{
+    if (mode != PLAYING || stopRequested)
+    {
+        return false;
+    }
+    unsigned long start = micros();
+    bool playing = true;
+    if (repeats > 0)
+    {
+        --repeats;
+    }
+    else if (used() == 0)
+    {
+        // out of data, which is either the end or the streamer falling behind
+        if (ended)
+        {
+            playing = false;
+        }
+        else
+        {
+            ++stats.underruns;
+        }
+    }
+    else
+    {
+        unsigned char header = peek(0);
+        unsigned long size = recordSize(header);
+        if (used() < size)
+        {
+            // the rest of the record hasn't been read yet
+            if (ended)
+            {
+                playing = false;
+            }
+            else
+            {
+                ++stats.underruns;
+            }
+        }
+        else if (header & REPEAT)
+        {
+            // this tick is one of the repeats
+            repeats = header & (MAX_REPEAT - 1);
+        }
+        else
+        {
+            unsigned long offset = 1;
+            for (unsigned int axis = 0; axis < AXIS_COUNT; ++axis)
+            {
+                if (header & (1 << axis))
+                {
+                    last.axes[axis] = (signed char) peek(offset++);
+                }
+            }
+            if (header & BUTTONS_CHANGED)
+            {
+                last.buttons ^= peek(offset) | (peek(offset + 1) << 8);
+            }
+        }
+        if (playing && used() >= size)
+        {
+            __sync_synchronize();
+            tail += size;
+            stats.bytes += size;
+        }
+    }
+    if (playing)
+    {
+        ++stats.ticks;
+        *state = last;
+    }
+    unsigned long took = micros() - start;
+    if (took > stats.maxPlayTime)
+    {
+        stats.maxPlayTime = took;
+    }
+    return playing && isAutonomous();
+}
+
+void input::stopPlayback()
+{
+    if (mode != PLAYING || stopRequested)
+    {
+        return;
+    }
+    printf("played %lu ticks from %lu bytes, %lu underruns, worst read %lu us, "
+        "worst tick %lu us\n", stats.ticks, stats.bytes, stats.underruns,
+        stats.maxReadTime, stats.maxPlayTime);
+    // the streamer could be in the middle of reading, so it closes the file
+    __sync_synchronize();
+    stopRequested = true;
+}
+
+input::StreamStats input::getStreamStats()
+{
+    return stats;
+}
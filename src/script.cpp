@@ -0,0 +1,212 @@
+// loads autonomous scripts from the cortex's file system and runs them
+
+#include "main.hpp"
+#include "script.hpp"
+
+// scripts are named SCRIPT_PREFIX followed by a number
+#define SCRIPT_PREFIX "auton"
+// the most scripts that can be on the cortex at once
+#define MAX_SCRIPTS 8
+// the longest a script's file name can be, including the null terminator
+#define SCRIPT_NAME_SIZE 9
+
+// names of the scripts that were found
+static char names[MAX_SCRIPTS][SCRIPT_NAME_SIZE];
+static unsigned int scriptCount = 0;
+
+// the script that's being run, loaded all at once so reading from the file
+//  system doesn't hold up autonomous
+static unsigned char program[SCRIPT_MAX_INSTRUCTIONS * SCRIPT_INSTRUCTION_SIZE];
+static unsigned int programSize;
+
+// used by wait() when it should just wait
+static bool never(void*)
+{
+    return false;
+}
+
+// used by wait() to wait on a parallel block
+struct Block
+{
+    auton::Handle handles[SCRIPT_MAX_INSTRUCTIONS];
+    unsigned int count;
+};
+
+static bool blockDone(void* arg)
+{
+    const Block* block = (const Block*) arg;
+    for (unsigned int i = 0; i < block->count; ++i)
+    {
+        if (!auton::isDone(block->handles[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// checks that every parallel block only has actions in it and doesn't go
+//  past the end of the program
+static bool validate()
+{
+    for (unsigned int pc = 0; pc < programSize; ++pc)
+    {
+        script::Instruction instruction =
+            script::decode(&program[pc * SCRIPT_INSTRUCTION_SIZE]);
+        if (instruction.op != script::OP_PARALLEL)
+        {
+            continue;
+        }
+        unsigned int end = pc + 1 + (unsigned short) instruction.a;
+        if (end > programSize)
+        {
+            return false;
+        }
+        for (unsigned int i = pc + 1; i < end; ++i)
+        {
+            if (!script::isAction(program[i * SCRIPT_INSTRUCTION_SIZE]))
+            {
+                return false;
+            }
+        }
+        pc = end - 1;
+    }
+    return true;
+}
+
+// loads a script into program, returns false if it's missing or broken
+static bool load(const char* name)
+{
+    FILE* file = fopen(name, "r");
+    if (file == NULL)
+    {
+        return false;
+    }
+    unsigned char header[SCRIPT_HEADER_SIZE];
+    bool ok = fread(header, 1, SCRIPT_HEADER_SIZE, file) == SCRIPT_HEADER_SIZE;
+    ok = ok && header[0] == SCRIPT_MAGIC[0] && header[1] == SCRIPT_MAGIC[1] &&
+        header[2] == SCRIPT_MAGIC[2] && header[3] == SCRIPT_MAGIC[3];
+    programSize = header[4] | (header[5] << 8);
+    ok = ok && programSize <= SCRIPT_MAX_INSTRUCTIONS;
+    ok = ok && fread(program, SCRIPT_INSTRUCTION_SIZE, programSize, file) ==
+        programSize;
+    fclose(file);
+    return ok && validate();
+}
+
+// starts the action for an instruction, returns false if it doesn't have one
+static bool launch(const script::Instruction& instruction,
+    auton::Handle* handle)
+{
+    using namespace script;
+    switch (instruction.op)
+    {
+    case OP_DRIVE:
+        *handle = auton::straight(instruction.a, instruction.arg);
+        return true;
+    case OP_TURN_CW:
+        *handle = auton::turnCW(instruction.a, instruction.b, instruction.arg);
+        return true;
+    case OP_TURN_CCW:
+        *handle = auton::turnCCW(instruction.a, instruction.b,
+            instruction.arg);
+        return true;
+    case OP_FOLLOW:
+        *handle = auton::follow(instruction.a, instruction.arg,
+            instruction.b != 0);
+        return true;
+    case OP_LIFT:
+        *handle = auton::lift((double) instruction.a / (1 << SCRIPT_POS_SHIFT));
+        return true;
+    case OP_CLAW:
+        *handle = auton::claw((motor::Direction) instruction.arg);
+        return true;
+    case OP_MGL:
+        *handle = auton::mgl((double) instruction.a / (1 << SCRIPT_POS_SHIFT));
+        return true;
+    case OP_STOP:
+        auton::stop();
+        return false;
+    case OP_WAIT:
+        auton::wait(never, NULL, (unsigned short) instruction.a, NULL);
+        return false;
+    default:
+        return false;
+    }
+}
+
+// declared in main.hpp
+
+void auton::findScripts()
+{
+    scriptCount = 0;
+    for (unsigned int i = 0; i < MAX_SCRIPTS; ++i)
+    {
+        char* name = names[scriptCount];
+        snprintf(name, SCRIPT_NAME_SIZE, SCRIPT_PREFIX "%u", i);
+        FILE* file = fopen(name, "r");
+        if (file != NULL)
+        {
+            fclose(file);
+            ++scriptCount;
+        }
+    }
+}
+
+unsigned int auton::getScriptCount()
+{
+    return scriptCount;
+}
+
+const char* auton::getScriptName(unsigned int index)
+{
+    return index < scriptCount ? names[index] : "";
+}
+
+bool auton::runScript(unsigned int index)
+{
+    if (index >= scriptCount || !load(names[index]))
+    {
+        return false;
+    }
+    // parallel blocks can be as big as the whole program
+    static Block block;
+    unsigned int pc = 0;
+    while (pc < programSize)
+    {
+        script::Instruction instruction =
+            script::decode(&program[pc * SCRIPT_INSTRUCTION_SIZE]);
+        ++pc;
+        if (instruction.op == script::OP_PARALLEL)
+        {
+            // start everything in the block, then wait for all of it
+            block.count = 0;
+            unsigned long budget = 0;
+            // load() already checked that it's all actions
+            unsigned int end = pc + (unsigned short) instruction.a;
+            for (; pc < end; ++pc)
+            {
+                Handle& handle = block.handles[block.count];
+                if (launch(script::decode(
+                    &program[pc * SCRIPT_INSTRUCTION_SIZE]), &handle))
+                {
+                    if (handle.action->getBudget() > budget)
+                    {
+                        budget = handle.action->getBudget();
+                    }
+                    ++block.count;
+                }
+            }
+            wait(blockDone, &block, budget, NULL);
+        }
+        else
+        {
+            Handle handle;
+            if (launch(instruction, &handle))
+            {
+                await(handle);
+            }
+        }
+    }
+    return true;
+}
@@ -2,13 +2,104 @@
 
 // digital ports
 #define LIFT_LIMIT 2
+// analog ports, 0 if there isn't a gyro plugged in
+// the odometry checks the gyro before using it, so leaving this set with
+//  nothing plugged in just means it never gets used
+#define GYRO_PORT 1
+
+// the gyro reads in 1/GYRO_SCALE degrees instead of whole degrees, since a
+//  bigger multiplier makes it report more degrees per rotation
+#define GYRO_SCALE 4
+#define GYRO_MULTIPLIER (196 * GYRO_SCALE)
+
+// how long the limit switch has to be let go (us) before pressing it again
+//  counts as a new contact, so it bouncing doesn't count
+#define LIFT_DEBOUNCE 5000ul
+
+// only the interrupt handler writes these
+static volatile bool liftDown = false;
+static volatile unsigned long liftContacts = 0;
+static volatile unsigned long liftContactTime = 0;
+// micros() when the switch was last let go
+static volatile unsigned long liftReleaseTime = 0;
+
+static Gyro gyro = NULL;
+
+// runs in an ISR on both edges of the limit switch, so it just remembers
+//  what happened and lets the motor controller deal with it
+static void onLiftLimit(unsigned char pin)
+{
+    unsigned long now = micros();
+    bool down = digitalRead(pin) == LOW;
+    if (down == liftDown)
+    {
+        return;
+    }
+    liftDown = down;
+    if (!down)
+    {
+        liftReleaseTime = now;
+        return;
+    }
+    if (liftContacts == 0 || now - liftReleaseTime >= LIFT_DEBOUNCE)
+    {
+        liftContactTime = now;
+        // getLiftContact() has to see the new time before the new count
+        __sync_synchronize();
+        ++liftContacts;
+    }
+}
+
+// declared in main.hpp
 
 void sensor::init()
 {
     pinMode(LIFT_LIMIT, INPUT);
+    // the robot could be turned on with the lift down, which doesn't count
+    //  as a contact since the IMEs start out at 0 anyway
+    liftDown = digitalRead(LIFT_LIMIT) == LOW;
+    ioSetInterrupt(LIFT_LIMIT, INTERRUPT_EDGE_BOTH, onLiftLimit);
+}
+
+void sensor::initGyro()
+{
+    // this calibrates the gyro, so the robot can't be moving
+    if (GYRO_PORT != 0)
+    {
+        gyro = gyroInit(GYRO_PORT, GYRO_MULTIPLIER);
+    }
+}
+
+bool sensor::hasGyro()
+{
+    return gyro != NULL;
+}
+
+long sensor::getGyroHeading()
+{
+    return (long) ((long long) gyroGet(gyro) * HEADING_PER_REV /
+        (360 * GYRO_SCALE));
 }
 
 bool sensor::isLiftDown()
 {
-    return digitalRead(LIFT_LIMIT) == LOW;
+    return liftDown;
+}
+
+sensor::LiftContact sensor::getLiftContact()
+{
+    LiftContact contact;
+    unsigned long contacts;
+    // the handler can't be interrupted by this, so if the count didn't
+    //  change while reading the time, the time goes with the count
+    do
+    {
+        contacts = liftContacts;
+        __sync_synchronize();
+        contact.time = liftContactTime;
+        __sync_synchronize();
+    }
+    while (contacts != liftContacts);
+    contact.contacts = contacts;
+    return contact;
 }
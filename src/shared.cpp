@@ -0,0 +1,62 @@
+// defines the lock-free Target that tasks share setpoints with
+
+#include "main.hpp"
+
+#define VALUE_MASK 0xfffful
+#define GENERATION_SHIFT 16
+// range of the fixed point value, which is a short
+#define VALUE_MIN -32768l
+#define VALUE_MAX 32767l
+
+// gets the value out of a Target's word
+static double decode(unsigned long word)
+{
+    return (short) (word & VALUE_MASK) / (double) (1 << TARGET_SHIFT);
+}
+
+// declared in main.hpp
+
+shared::Target::Target(): word(0) {}
+
+void shared::Target::set(double value)
+{
+    // compared as a double first so a huge value can't overflow the long
+    double scaled = floor(value * (1 << TARGET_SHIFT) + 0.5);
+    long clamped = scaled > VALUE_MAX ? VALUE_MAX : scaled < VALUE_MIN ?
+        VALUE_MIN : (long) scaled;
+    unsigned long fixed = (unsigned long) clamped & VALUE_MASK;
+    unsigned long old;
+    unsigned long next;
+    // another task might have set it in between, in which case this set
+    //  comes after that one
+    do
+    {
+        old = word;
+        next = ((old + (1ul << GENERATION_SHIFT)) & ~VALUE_MASK) | fixed;
+    }
+    while (!__sync_bool_compare_and_swap(&word, old, next));
+}
+
+double shared::Target::get() const
+{
+    return decode(word);
+}
+
+double shared::Target::get(unsigned int& generation) const
+{
+    unsigned long current = word;
+    generation = current >> GENERATION_SHIFT;
+    return decode(current);
+}
+
+long shared::Target::getFixed(unsigned int& generation) const
+{
+    unsigned long current = word;
+    generation = current >> GENERATION_SHIFT;
+    return (short) (current & VALUE_MASK);
+}
+
+unsigned int shared::Target::getGeneration() const
+{
+    return word >> GENERATION_SHIFT;
+}
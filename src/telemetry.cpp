@@ -0,0 +1,347 @@
+// logs compact binary records to flash without making the control loop wait
+//
+// every task that logs something puts a record in a lock-free ring, and the
+//  writer task moves them into a batch that's written to the file in one
+//  fwrite() once it's full
+
+#include "main.hpp"
+#include "telemetry.hpp"
+
+// records the ring can hold, has to be a power of 2
+#define RING_SIZE 64u
+// records that are written to the file at a time
+#define BATCH_RECORDS 50u
+#define BATCH_SIZE (BATCH_RECORDS * TELEMETRY_RECORD_SIZE)
+// how often the writer empties the ring in milliseconds
+#define WRITE_RATE 50
+// how often a partly full batch gets written anyways, in milliseconds
+#define BATCH_TIMEOUT 1000ul
+// the least time (ms) between records of each type, the battery gets logged
+//  as often as it's asked to
+#define IMES_RATE 100ul
+#define MOTORS_RATE 100ul
+#define JOYSTICK_RATE 100ul
+
+// a record that hasn't been written yet
+// slot n's sequence is n when it's free for the nth record, n + 1 once the
+//  nth record is in it, and n + RING_SIZE once the writer has taken it out
+struct Slot
+{
+    volatile unsigned long sequence;
+    unsigned long time;
+    unsigned char type;
+    unsigned char payload[TELEMETRY_PAYLOAD_SIZE];
+};
+
+static Slot ring[RING_SIZE];
+// where the next record goes, any task can move it with a compare and swap
+static volatile unsigned long enqueued = 0;
+// where the next record comes out, only the writer moves it
+static unsigned long dequeued = 0;
+
+// file that start() asked for, and how many times it's been called so the
+//  writer can tell when there's a new one
+static const char* volatile requestedFile = NULL;
+static volatile unsigned long requests = 0;
+// whether records are being accepted, only the writer changes it
+static volatile bool logging = false;
+// when the last record of each type was logged, see log()
+static unsigned long lastLogged[telemetry::RECORD_TYPE_COUNT];
+
+// only the writer uses these
+static FILE* file = NULL;
+static unsigned char batch[BATCH_SIZE];
+static unsigned long batchSize = 0;
+static unsigned long batchStart = 0;
+// time of the last record that went into the file
+static unsigned long lastTime = 0;
+static unsigned long fileSize = 0;
+
+static telemetry::Stats stats;
+static timing::LoopTimer writeTimer("telem", WRITE_RATE);
+
+// puts a record in the ring, or drops it if the ring is full
+static void put(telemetry::RecordType type, const unsigned char* payload,
+    unsigned long time)
+{
+    unsigned long position = enqueued;
+    Slot* slot;
+    while (true)
+    {
+        slot = &ring[position % RING_SIZE];
+        long difference = (long) (slot->sequence - position);
+        if (difference == 0)
+        {
+            // claim the slot before anyone else does
+            if (__sync_bool_compare_and_swap(&enqueued, position,
+                position + 1))
+            {
+                break;
+            }
+            position = enqueued;
+        }
+        else if (difference < 0)
+        {
+            // the writer hasn't gotten to this slot's last record yet
+            __sync_fetch_and_add(&stats.dropped, 1);
+            return;
+        }
+        else
+        {
+            // someone else claimed it first
+            position = enqueued;
+        }
+    }
+    slot->time = time;
+    slot->type = type;
+    for (unsigned int i = 0; i < TELEMETRY_PAYLOAD_SIZE; ++i)
+    {
+        slot->payload[i] = payload[i];
+    }
+    // the writer has to see the record before it sees it's there
+    __sync_synchronize();
+    slot->sequence = position + 1;
+    __sync_fetch_and_add(&stats.records, 1);
+}
+
+// logs a record if it's been at least rate ms since the last one of its type
+static void log(telemetry::RecordType type, const unsigned char* payload,
+    unsigned long rate)
+{
+    if (!logging)
+    {
+        return;
+    }
+    unsigned long now = millis();
+    if (lastLogged[type] != 0 && now - lastLogged[type] < rate)
+    {
+        return;
+    }
+    lastLogged[type] = now;
+    put(type, payload, now);
+}
+
+// takes the next record out of the ring, returns false if there isn't one
+//  or it isn't done being put in yet
+static bool take(telemetry::Record& record, unsigned long& time)
+{
+    Slot& slot = ring[dequeued % RING_SIZE];
+    if (slot.sequence != dequeued + 1)
+    {
+        return false;
+    }
+    time = slot.time;
+    record.type = slot.type;
+    for (unsigned int i = 0; i < TELEMETRY_PAYLOAD_SIZE; ++i)
+    {
+        record.payload[i] = slot.payload[i];
+    }
+    // the record has to be copied out before the slot gets reused
+    __sync_synchronize();
+    slot.sequence = dequeued + RING_SIZE;
+    ++dequeued;
+    return true;
+}
+
+// writes the batch to the file in one go
+static void writeBatch()
+{
+    if (batchSize == 0)
+    {
+        return;
+    }
+    unsigned long start = micros();
+    fwrite(batch, 1, batchSize, file);
+    unsigned long took = micros() - start;
+    if (took > stats.maxWriteTime)
+    {
+        stats.maxWriteTime = took;
+    }
+    stats.bytes += batchSize;
+    ++stats.writes;
+    fileSize += batchSize;
+    batchSize = 0;
+}
+
+static void closeFile()
+{
+    logging = false;
+    if (file != NULL)
+    {
+        writeBatch();
+        fclose(file);
+        file = NULL;
+    }
+}
+
+static void openFile(const char* name)
+{
+    closeFile();
+    file = fopen(name, "w");
+    if (file == NULL)
+    {
+        return;
+    }
+    unsigned char header[TELEMETRY_HEADER_SIZE];
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        header[i] = TELEMETRY_MAGIC[i];
+    }
+    lastTime = millis();
+    telemetry::putLong(header + 4, lastTime);
+    fwrite(header, 1, TELEMETRY_HEADER_SIZE, file);
+    fileSize = TELEMETRY_HEADER_SIZE;
+    batchStart = lastTime;
+    for (unsigned int i = 0; i < telemetry::RECORD_TYPE_COUNT; ++i)
+    {
+        lastLogged[i] = 0;
+    }
+    logging = true;
+}
+
+// moves everything in the ring into the batch, and writes the batch once
+//  it's full
+static void drain()
+{
+    telemetry::Record record;
+    unsigned long time;
+    while (take(record, time))
+    {
+        if (file == NULL ||
+            fileSize + batchSize + TELEMETRY_RECORD_SIZE > TELEMETRY_MAX_SIZE)
+        {
+            // a record from before the log ended, or the file is full
+            __sync_fetch_and_add(&stats.dropped, 1);
+            continue;
+        }
+        long delta = (long) (time - lastTime);
+        if (delta > 32767)
+        {
+            delta = 32767;
+        }
+        else if (delta < -32768)
+        {
+            delta = -32768;
+        }
+        record.delta = (short) delta;
+        lastTime += delta;
+        telemetry::encode(record, batch + batchSize);
+        batchSize += TELEMETRY_RECORD_SIZE;
+        if (batchSize >= BATCH_SIZE)
+        {
+            writeBatch();
+            batchStart = millis();
+        }
+    }
+    if (file != NULL && millis() - batchStart >= BATCH_TIMEOUT)
+    {
+        writeBatch();
+        batchStart = millis();
+    }
+}
+
+// declared in main.hpp
+
+void telemetry::start(const char* name)
+{
+    requestedFile = name;
+    __sync_synchronize();
+    ++requests;
+}
+
+void telemetry::stop()
+{
+    start(NULL);
+}
+
+void telemetry::logImes(const int* counts)
+{
+    unsigned char payload[TELEMETRY_PAYLOAD_SIZE] = {0};
+    for (unsigned int i = 0; i < TELEMETRY_IMES; ++i)
+    {
+        putLong(payload + 4 * i, counts[i]);
+    }
+    log(RECORD_IMES, payload, IMES_RATE);
+}
+
+void telemetry::logMotors(const int* outputs)
+{
+    unsigned char payload[TELEMETRY_PAYLOAD_SIZE] = {0};
+    for (unsigned int i = 0; i < TELEMETRY_PORTS; ++i)
+    {
+        payload[i] = (unsigned char) outputs[i];
+    }
+    log(RECORD_MOTORS, payload, MOTORS_RATE);
+}
+
+void telemetry::logJoystick(const input::State& state)
+{
+    unsigned char payload[TELEMETRY_PAYLOAD_SIZE] = {0};
+    for (unsigned int i = 0; i < TELEMETRY_AXES; ++i)
+    {
+        payload[i] = (unsigned char) state.axes[i];
+    }
+    putShort(payload + TELEMETRY_AXES, state.buttons);
+    log(RECORD_JOYSTICK, payload, JOYSTICK_RATE);
+}
+
+void telemetry::logBattery()
+{
+    if (!logging)
+    {
+        return;
+    }
+    unsigned char payload[TELEMETRY_PAYLOAD_SIZE] = {0};
+    putShort(payload, powerLevelMain());
+    putShort(payload + 2, powerLevelBackup());
+    putShort(payload + 4, motor::getFrame().getBattery());
+    log(RECORD_BATTERY, payload, 0);
+}
+
+void telemetry::writer(void*)
+{
+    // every slot starts out free for the first record that goes in it
+    for (unsigned int i = 0; i < RING_SIZE; ++i)
+    {
+        ring[i].sequence = i;
+    }
+    // start() could've been called before this task ever ran
+    unsigned long handled = 0;
+    // used for timing cyclic delays
+    unsigned long time = millis();
+    writeTimer.enter();
+    while (true)
+    {
+        writeTimer.start();
+        if (handled != requests)
+        {
+            handled = requests;
+            __sync_synchronize();
+            const char* name = requestedFile;
+            // anything from the old log still goes in the old file
+            drain();
+            if (name != NULL)
+            {
+                openFile(name);
+            }
+            else
+            {
+                closeFile();
+            }
+        }
+        else if (file != NULL && !isEnabled())
+        {
+            // the robot could get turned off any time now
+            drain();
+            closeFile();
+        }
+        drain();
+        writeTimer.stop();
+        taskDelayUntil(&time, WRITE_RATE);
+    }
+}
+
+telemetry::Stats telemetry::getStats()
+{
+    return stats;
+}
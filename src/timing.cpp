@@ -0,0 +1,187 @@
+// defines the LoopTimer, which measures how well loops keep to their periods
+
+#include "main.hpp"
+
+// the smallest jitter bin, jitter bin n + 1 holds up to 64us << n
+#define JITTER_SHIFT 6
+// how often the dumper checks if a dump was asked for, in ms
+#define DUMP_RATE 100ul
+
+static const timing::LoopTimer* timers[MAX_LOOP_TIMERS];
+static unsigned int timerCount = 0;
+// goes up every time requestDump() is called
+static volatile unsigned long dumpRequests = 0;
+
+// picks a bin that's width wide, the last bin holds anything past the end
+static unsigned int getLinearBin(unsigned long value, unsigned long width)
+{
+    unsigned long bin = value / width;
+    return bin < TIMING_BINS ? bin : TIMING_BINS - 1;
+}
+
+// bin 0 holds anything under 1 << JITTER_SHIFT, each bin after that holds
+//  up to twice as much as the one before it
+static unsigned int getPowerBin(unsigned long value)
+{
+    value >>= JITTER_SHIFT;
+    if (value == 0)
+    {
+        return 0;
+    }
+    // the cortex has an instruction for this, and longs are 64 bits on the
+    //  simulator
+    unsigned int bin = sizeof(unsigned long) * 8 - __builtin_clzl(value);
+    return bin < TIMING_BINS ? bin : TIMING_BINS - 1;
+}
+
+static void printHistogram(const char* name, const timing::Histogram bins)
+{
+    printf("  %-7s", name);
+    for (unsigned int i = 0; i < TIMING_BINS; ++i)
+    {
+        printf(" %6lu", bins[i]);
+    }
+    printf("\n");
+}
+
+// declared in main.hpp
+
+timing::LoopTimer::LoopTimer(const char* name, unsigned long period):
+    name(name), period(period * 1000), lastStart(0), entered(false),
+    runs(0), misses(0),
+    maxJitter(0), maxExecTime(0)
+{
+    for (unsigned int i = 0; i < TIMING_BINS; ++i)
+    {
+        periods[i] = 0;
+        execTimes[i] = 0;
+        jitters[i] = 0;
+    }
+    if (timerCount < MAX_LOOP_TIMERS)
+    {
+        timers[timerCount++] = this;
+    }
+}
+
+void timing::LoopTimer::enter()
+{
+    entered = false;
+}
+
+void timing::LoopTimer::start()
+{
+    unsigned long now = micros();
+    // the first iteration doesn't have a period to measure
+    if (entered)
+    {
+        unsigned long actual = now - lastStart;
+        unsigned long jitter = actual > period ? actual - period :
+            period - actual;
+        ++periods[getLinearBin(actual, 2 * period / TIMING_BINS)];
+        ++jitters[getPowerBin(jitter)];
+        if (jitter > maxJitter)
+        {
+            maxJitter = jitter;
+        }
+        if (actual > period + period / 4)
+        {
+            ++misses;
+        }
+    }
+    lastStart = now;
+    entered = true;
+}
+
+void timing::LoopTimer::stop()
+{
+    unsigned long took = micros() - lastStart;
+    ++execTimes[getLinearBin(took, period / TIMING_BINS)];
+    if (took > maxExecTime)
+    {
+        maxExecTime = took;
+    }
+    ++runs;
+}
+
+const char* timing::LoopTimer::getName() const
+{
+    return name;
+}
+
+unsigned long timing::LoopTimer::getRuns() const
+{
+    return runs;
+}
+
+unsigned long timing::LoopTimer::getMisses() const
+{
+    return misses;
+}
+
+unsigned long timing::LoopTimer::getMaxJitter() const
+{
+    return maxJitter;
+}
+
+unsigned long timing::LoopTimer::getMaxExecTime() const
+{
+    return maxExecTime;
+}
+
+void timing::LoopTimer::dump() const
+{
+    printf("loop %s: %lu ms, %lu runs, %lu misses, max jitter %lu us, "
+        "max exec %lu us\n", name, period / 1000, runs, misses, maxJitter,
+        maxExecTime);
+    printf("  period  bins are %lu us wide\n", 2 * period / TIMING_BINS);
+    printHistogram("period", periods);
+    printf("  exec    bins are %lu us wide\n", period / TIMING_BINS);
+    printHistogram("exec", execTimes);
+    printf("  jitter  bins end at %u us and double\n", 1u << JITTER_SHIFT);
+    printHistogram("jitter", jitters);
+}
+
+unsigned int timing::getTimerCount()
+{
+    return timerCount;
+}
+
+const timing::LoopTimer* timing::getTimer(unsigned int index)
+{
+    return index < timerCount ? timers[index] : NULL;
+}
+
+void timing::dump()
+{
+    for (unsigned int i = 0; i < timerCount; ++i)
+    {
+        timers[i]->dump();
+    }
+}
+
+void timing::requestDump()
+{
+    ++dumpRequests;
+}
+
+// the dumper's own loop gets timed like the rest
+static timing::LoopTimer dumpTimer("dump", DUMP_RATE);
+
+void timing::dumper(void*)
+{
+    unsigned long handled = 0;
+    // used for timing cyclic delays
+    unsigned long time = millis();
+    dumpTimer.enter();
+    while (true)
+    {
+        dumpTimer.start();
+        if (handled != dumpRequests)
+        {
+            handled = dumpRequests;
+            dump();
+        }
+        dumpTimer.stop();
+        taskDelayUntil(&time, DUMP_RATE);
+    }
+}
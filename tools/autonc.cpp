@@ -0,0 +1,248 @@
+// compiles the text form of an autonomous script into the binary form that
+//  the robot runs (see include/script.hpp)
+//
+// usage: autonc <input.txt> <output>
+//
+// every line is one instruction, and anything after a # is ignored:
+//  drive <distance> <power>           distance in 1/16 inches
+//  turn <cw|ccw> <angle> <radius> <power>
+//  follow <path> <power> [mirror]     path is its index in tools/paths.txt
+//  stop
+//  lift <position>                    0 to 127, decimals are ok
+//  claw <open|close|stop>
+//  mgl <position>
+//  wait <ms>
+//  parallel                           everything up to the next "end" runs
+//  ...                                 at the same time, which can't be a
+//  end                                 stop or a wait
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "script.hpp"
+
+// longest line that can be read
+#define LINE_SIZE 256
+
+static script::Instruction program[SCRIPT_MAX_INSTRUCTIONS];
+static unsigned int programSize = 0;
+
+// prints an error for a line and quits
+static void fail(unsigned int line, const char* message)
+{
+    fprintf(stderr, "line %u: %s\n", line, message);
+    exit(1);
+}
+
+// reads the next word from a line as an integer
+static long number(unsigned int line)
+{
+    const char* word = strtok(NULL, " \t");
+    if (word == NULL)
+    {
+        fail(line, "missing number");
+    }
+    char* end;
+    long value = strtol(word, &end, 10);
+    if (*end != '\0')
+    {
+        fail(line, "not a number");
+    }
+    return value;
+}
+
+// reads the next word from a line as a fixed point position
+static long position(unsigned int line)
+{
+    const char* word = strtok(NULL, " \t");
+    if (word == NULL)
+    {
+        fail(line, "missing position");
+    }
+    char* end;
+    double value = strtod(word, &end);
+    if (*end != '\0')
+    {
+        fail(line, "not a position");
+    }
+    return (long) (value * (1 << SCRIPT_POS_SHIFT) + (value < 0 ? -0.5 : 0.5));
+}
+
+// makes sure a number fits in an instruction field
+static long check(unsigned int line, long value, long min, long max)
+{
+    if (value < min || value > max)
+    {
+        fail(line, "number out of range");
+    }
+    return value;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <input.txt> <output>\n", argv[0]);
+        return 1;
+    }
+    FILE* input = fopen(argv[1], "r");
+    if (input == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    char text[LINE_SIZE];
+    unsigned int line = 0;
+    // index of the parallel instruction that's still open, or -1
+    long block = -1;
+    while (fgets(text, sizeof(text), input) != NULL)
+    {
+        ++line;
+        text[strcspn(text, "#\r\n")] = '\0';
+        const char* op = strtok(text, " \t");
+        if (op == NULL)
+        {
+            continue;
+        }
+        if (strcmp(op, "end") == 0)
+        {
+            if (block < 0)
+            {
+                fail(line, "end without parallel");
+            }
+            program[block].a = programSize - block - 1;
+            block = -1;
+            continue;
+        }
+        if (programSize >= SCRIPT_MAX_INSTRUCTIONS)
+        {
+            fail(line, "too many instructions");
+        }
+        script::Instruction& instruction = program[programSize];
+        memset(&instruction, 0, sizeof(instruction));
+        if (strcmp(op, "drive") == 0)
+        {
+            instruction.op = script::OP_DRIVE;
+            instruction.a = check(line, number(line), 0, 32767);
+            instruction.arg = check(line, number(line), -127, 127);
+        }
+        else if (strcmp(op, "turn") == 0)
+        {
+            const char* way = strtok(NULL, " \t");
+            if (way != NULL && strcmp(way, "cw") == 0)
+            {
+                instruction.op = script::OP_TURN_CW;
+            }
+            else if (way != NULL && strcmp(way, "ccw") == 0)
+            {
+                instruction.op = script::OP_TURN_CCW;
+            }
+            else
+            {
+                fail(line, "turn has to be cw or ccw");
+            }
+            instruction.a = check(line, number(line), 0, 32767);
+            instruction.b = check(line, number(line), 0, 32767);
+            instruction.arg = check(line, number(line), -127, 127);
+        }
+        else if (strcmp(op, "follow") == 0)
+        {
+            instruction.op = script::OP_FOLLOW;
+            instruction.a = check(line, number(line), 0, 32767);
+            instruction.arg = check(line, number(line), -127, 127);
+            const char* mirror = strtok(NULL, " \t");
+            if (mirror != NULL && strcmp(mirror, "mirror") == 0)
+            {
+                instruction.b = 1;
+            }
+            else if (mirror != NULL)
+            {
+                fail(line, "follow can only be mirrored");
+            }
+        }
+        else if (strcmp(op, "stop") == 0)
+        {
+            instruction.op = script::OP_STOP;
+        }
+        else if (strcmp(op, "lift") == 0 || strcmp(op, "mgl") == 0)
+        {
+            instruction.op = op[0] == 'l' ? script::OP_LIFT : script::OP_MGL;
+            instruction.a = check(line, position(line), -32768, 32767);
+        }
+        else if (strcmp(op, "claw") == 0)
+        {
+            const char* way = strtok(NULL, " \t");
+            instruction.op = script::OP_CLAW;
+            // same values as motor::Direction
+            if (way != NULL && strcmp(way, "close") == 0)
+            {
+                instruction.arg = 1;
+            }
+            else if (way != NULL && strcmp(way, "open") == 0)
+            {
+                instruction.arg = -1;
+            }
+            else if (way == NULL || strcmp(way, "stop") != 0)
+            {
+                fail(line, "claw has to be open, close, or stop");
+            }
+        }
+        else if (strcmp(op, "wait") == 0)
+        {
+            instruction.op = script::OP_WAIT;
+            instruction.a = check(line, number(line), 0, 65535);
+        }
+        else if (strcmp(op, "parallel") == 0)
+        {
+            if (block >= 0)
+            {
+                fail(line, "parallel blocks can't be nested");
+            }
+            instruction.op = script::OP_PARALLEL;
+            block = programSize;
+        }
+        else
+        {
+            fail(line, "unknown instruction");
+        }
+        if (strtok(NULL, " \t") != NULL)
+        {
+            fail(line, "too many arguments");
+        }
+        if (block >= 0 && instruction.op != script::OP_PARALLEL &&
+            !script::isAction(instruction.op))
+        {
+            fail(line, "only actions can go in a parallel block");
+        }
+        ++programSize;
+    }
+    fclose(input);
+    if (block >= 0)
+    {
+        fail(line, "parallel without end");
+    }
+    FILE* output = fopen(argv[2], "wb");
+    if (output == NULL)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+    unsigned char header[SCRIPT_HEADER_SIZE] =
+    {
+        SCRIPT_MAGIC[0], SCRIPT_MAGIC[1], SCRIPT_MAGIC[2], SCRIPT_MAGIC[3],
+        (unsigned char) (programSize & 0xff), (unsigned char) (programSize >> 8),
+        0, 0
+    };
+    fwrite(header, 1, sizeof(header), output);
+    for (unsigned int i = 0; i < programSize; ++i)
+    {
+        unsigned char bytes[SCRIPT_INSTRUCTION_SIZE];
+        script::encode(program[i], bytes);
+        fwrite(bytes, 1, sizeof(bytes), output);
+    }
+    fclose(output);
+    printf("%s: %u instructions, %u bytes\n", argv[2], programSize,
+        SCRIPT_HEADER_SIZE + programSize * SCRIPT_INSTRUCTION_SIZE);
+    return 0;
+}
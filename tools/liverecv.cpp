@@ -0,0 +1,288 @@
+// receives the live telemetry that the robot streams over uart2 (see
+//  include/live.hpp) and reports how much of it made it through
+//
+// usage: liverecv [-v] [-b baud] <device>
+//  -v          prints every packet
+//  -b <baud>   baud rate if the device is a serial port (default 115200)
+//
+// the device can be a serial port, a pty, a fifo or a file, and it reads
+//  until that runs out or it's stopped with ctrl-c
+// once a second, and again at the end, it prints how many packets came in,
+//  how many were lost or corrupted, and how many channel values per second
+//  of robot time that works out to
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "live.hpp"
+#include "telemetry.hpp"
+
+static const char* channelNames[live::CHANNEL_COUNT] =
+{
+    "left", "right", "lift", "x", "y", "heading", "battery"
+};
+
+struct Totals
+{
+    unsigned long bytes;
+    unsigned long packets;
+    // frames that weren't valid COBS, had a bad CRC or were the wrong size
+    unsigned long corrupted;
+    // packets that never showed up, going by the sequence numbers
+    unsigned long lost;
+    // values received on each channel
+    unsigned long values[live::CHANNEL_COUNT];
+    // robot time of the first and last packets
+    unsigned long firstTime;
+    unsigned long lastTime;
+    unsigned int lastSequence;
+};
+
+static volatile bool stopped = false;
+
+static void stop(int)
+{
+    stopped = true;
+}
+
+static double now()
+{
+    struct timeval time;
+    gettimeofday(&time, NULL);
+    return time.tv_sec + time.tv_usec / 1000000.0;
+}
+
+static speed_t toSpeed(long baud)
+{
+    switch (baud)
+    {
+    case 9600:
+        return B9600;
+    case 19200:
+        return B19200;
+    case 38400:
+        return B38400;
+    case 57600:
+        return B57600;
+    case 230400:
+        return B230400;
+    default:
+        return B115200;
+    }
+}
+
+// makes a serial port (or a pty) pass bytes through untouched
+static void makeRaw(int device, long baud)
+{
+    struct termios settings;
+    if (tcgetattr(device, &settings) != 0)
+    {
+        return;
+    }
+    cfmakeraw(&settings);
+    cfsetispeed(&settings, toSpeed(baud));
+    cfsetospeed(&settings, toSpeed(baud));
+    tcsetattr(device, TCSANOW, &settings);
+}
+
+static unsigned int countBits(unsigned int mask)
+{
+    unsigned int count = 0;
+    for (; mask != 0; mask &= mask - 1)
+    {
+        ++count;
+    }
+    return count;
+}
+
+// checks and unpacks one frame (without the 0 at the end)
+static void receive(const unsigned char* frame, unsigned int size,
+    Totals& totals, bool verbose)
+{
+    unsigned char packet[LIVE_PACKET_SIZE + 1];
+    unsigned int length;
+    if (size > LIVE_FRAME_SIZE || !live::decode(frame, size, packet, length) ||
+        length < LIVE_HEADER_SIZE + LIVE_CRC_SIZE ||
+        telemetry::getShort(packet + length - LIVE_CRC_SIZE) !=
+        live::crc16(packet, length - LIVE_CRC_SIZE))
+    {
+        ++totals.corrupted;
+        return;
+    }
+    unsigned int mask = telemetry::getShort(packet + 6);
+    if (mask >> live::CHANNEL_COUNT != 0 || length != LIVE_HEADER_SIZE +
+        countBits(mask) * LIVE_VALUE_SIZE + LIVE_CRC_SIZE)
+    {
+        ++totals.corrupted;
+        return;
+    }
+    unsigned int sequence = telemetry::getShort(packet);
+    unsigned long time = telemetry::getLong(packet + 2);
+    if (totals.packets == 0)
+    {
+        totals.firstTime = time;
+    }
+    else
+    {
+        totals.lost += (sequence - totals.lastSequence - 1) & 0xffff;
+    }
+    ++totals.packets;
+    totals.lastSequence = sequence;
+    totals.lastTime = time;
+    if (verbose)
+    {
+        printf("%lu #%u", time, sequence);
+    }
+    const unsigned char* value = packet + LIVE_HEADER_SIZE;
+    for (unsigned int i = 0; i < live::CHANNEL_COUNT; ++i)
+    {
+        if (mask & (1 << i))
+        {
+            ++totals.values[i];
+            if (verbose)
+            {
+                printf(" %s=%ld", channelNames[i],
+                    (long) (int) telemetry::getLong(value));
+            }
+            value += LIVE_VALUE_SIZE;
+        }
+    }
+    if (verbose)
+    {
+        printf("\n");
+    }
+}
+
+static void report(const Totals& totals, double seconds)
+{
+    unsigned long expected = totals.packets + totals.lost;
+    double span = (totals.lastTime - totals.firstTime) / 1000.0;
+    unsigned long values = 0;
+    for (unsigned int i = 0; i < live::CHANNEL_COUNT; ++i)
+    {
+        values += totals.values[i];
+    }
+    printf("%lu packets, %lu lost (%.2f%%), %lu corrupted, %.0f bytes/s\n",
+        totals.packets, totals.lost,
+        expected > 0 ? 100.0 * totals.lost / expected : 0.0,
+        totals.corrupted, seconds > 0 ? totals.bytes / seconds : 0.0);
+    if (span <= 0)
+    {
+        return;
+    }
+    printf("  %.1f channels*Hz over %.2f s of robot time:", values / span,
+        span);
+    for (unsigned int i = 0; i < live::CHANNEL_COUNT; ++i)
+    {
+        if (totals.values[i] > 0)
+        {
+            printf(" %s %.1f Hz", channelNames[i], totals.values[i] / span);
+        }
+    }
+    printf("\n");
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: liverecv [-v] [-b baud] <device>\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    bool verbose = false;
+    long baud = 115200;
+    int option;
+    while ((option = getopt(argc, argv, "vb:")) != -1)
+    {
+        switch (option)
+        {
+        case 'v':
+            verbose = true;
+            break;
+        case 'b':
+            baud = atol(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind != argc - 1)
+    {
+        usage();
+    }
+    int device = open(argv[optind], O_RDONLY | O_NOCTTY);
+    if (device < 0)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    if (isatty(device))
+    {
+        makeRaw(device, baud);
+    }
+    // ctrl-c should stop the read and still print the report
+    struct sigaction action = {};
+    action.sa_handler = stop;
+    sigaction(SIGINT, &action, NULL);
+    Totals totals = {};
+    unsigned char frame[LIVE_FRAME_SIZE];
+    unsigned int size = 0;
+    // set when a frame is too long, so the rest of it gets skipped
+    bool overflowed = false;
+    double start = now();
+    double lastReport = start;
+    unsigned char bytes[256];
+    while (!stopped)
+    {
+        ssize_t count = read(device, bytes, sizeof(bytes));
+        if (count <= 0)
+        {
+            // a pty gives EIO once the other end is closed
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        totals.bytes += count;
+        for (ssize_t i = 0; i < count; ++i)
+        {
+            if (bytes[i] == 0)
+            {
+                if (overflowed)
+                {
+                    ++totals.corrupted;
+                }
+                else if (size > 0)
+                {
+                    receive(frame, size, totals, verbose);
+                }
+                size = 0;
+                overflowed = false;
+            }
+            else if (size < sizeof(frame))
+            {
+                frame[size++] = bytes[i];
+            }
+            else
+            {
+                overflowed = true;
+            }
+        }
+        if (!verbose && now() - lastReport >= 1)
+        {
+            lastReport = now();
+            report(totals, lastReport - start);
+        }
+    }
+    close(device);
+    report(totals, now() - start);
+    return 0;
+}
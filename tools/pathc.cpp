@@ -0,0 +1,366 @@
+// turns the waypoints in a path file into the source file with every path
+//  that auton::follow() can drive along (see include/path.hpp)
+//
+// usage: pathc <paths.txt> <paths.cpp>
+//
+// anything after a # is ignored, and every path looks like:
+//  path <name>
+//  <x> <y>                 at least 2 waypoints, in 1/16 inches
+//  ...
+//  end
+// waypoints are in the odometry's coordinates, so x is forwards and y is to
+//  the left from where the robot was when autonomous started
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "path.hpp"
+
+// longest line that can be read
+#define LINE_SIZE 256
+#define NAME_SIZE 32
+
+struct Vector
+{
+    double x;
+    double y;
+};
+
+// a point every 1/16 inch along a path
+struct Sample
+{
+    Vector position;
+    // 1/radius of the curve it's on, 0 if it's on a straight part
+    double curvature;
+};
+
+struct Path
+{
+    char name[NAME_SIZE];
+    std::vector<Vector> waypoints;
+};
+
+static std::vector<Path> paths;
+
+// prints an error for a line and quits
+static void fail(unsigned int line, const char* message)
+{
+    fprintf(stderr, "line %u: %s\n", line, message);
+    exit(1);
+}
+
+static Vector add(Vector a, Vector b, double scale)
+{
+    Vector sum = { a.x + b.x * scale, a.y + b.y * scale };
+    return sum;
+}
+
+static double distance(Vector a, Vector b)
+{
+    return hypot(b.x - a.x, b.y - a.y);
+}
+
+// unit vector pointing from a to b
+static Vector direction(Vector a, Vector b)
+{
+    double length = distance(a, b);
+    Vector unit = { (b.x - a.x) / length, (b.y - a.y) / length };
+    return unit;
+}
+
+// walks a straight line, putting a sample every 1/16 inch
+// offset is how far into the line the next sample is, and gets set to how
+//  far into whatever comes next it'll be
+static void walkLine(Vector start, Vector end, double& offset,
+    std::vector<Sample>& samples)
+{
+    double length = distance(start, end);
+    if (length <= 0)
+    {
+        return;
+    }
+    Vector unit = direction(start, end);
+    for (; offset < length; offset += 1)
+    {
+        Sample sample = { add(start, unit, offset), 0 };
+        samples.push_back(sample);
+    }
+    offset -= length;
+}
+
+// walks an arc around a center from one angle to another
+static void walkArc(Vector center, double radius, double from, double to,
+    double& offset, std::vector<Sample>& samples)
+{
+    double length = fabs(to - from) * radius;
+    double way = to > from ? 1 : -1;
+    for (; offset < length; offset += 1)
+    {
+        double angle = from + way * offset / radius;
+        Sample sample = {{ center.x + radius * cos(angle),
+            center.y + radius * sin(angle) }, 1 / radius};
+        samples.push_back(sample);
+    }
+    offset -= length;
+}
+
+// goes along the waypoints, rounding off every corner with an arc
+static std::vector<Sample> walk(const std::vector<Vector>& waypoints)
+{
+    std::vector<Sample> samples;
+    double offset = 0;
+    // where the part of the path that hasn't been walked yet starts
+    Vector start = waypoints[0];
+    for (size_t i = 1; i + 1 < waypoints.size(); ++i)
+    {
+        Vector corner = waypoints[i];
+        Vector in = direction(waypoints[i - 1], corner);
+        Vector out = direction(corner, waypoints[i + 1]);
+        // how much the path turns at the corner, positive is to the left
+        double turn = atan2(in.x * out.y - in.y * out.x,
+            in.x * out.x + in.y * out.y);
+        if (fabs(turn) < 1e-6)
+        {
+            continue;
+        }
+        // how far before and after the corner the arc touches the lines,
+        //  which can't be more than half of either line
+        double radius = PATH_CORNER_RADIUS;
+        double tangent = radius * tan(fabs(turn) / 2);
+        double limit = distance(start, corner);
+        if (distance(corner, waypoints[i + 1]) / 2 < limit)
+        {
+            limit = distance(corner, waypoints[i + 1]) / 2;
+        }
+        if (tangent > limit)
+        {
+            tangent = limit;
+            radius = tangent / tan(fabs(turn) / 2);
+        }
+        Vector enter = add(corner, in, -tangent);
+        walkLine(start, enter, offset, samples);
+        double side = turn > 0 ? 1 : -1;
+        // the center is off to the side the path turns towards
+        Vector normal = { -in.y * side, in.x * side };
+        Vector center = add(enter, normal, radius);
+        double from = atan2(enter.y - center.y, enter.x - center.x);
+        walkArc(center, radius, from, from + turn, offset, samples);
+        start = add(corner, out, tangent);
+    }
+    walkLine(start, waypoints.back(), offset, samples);
+    // the last waypoint is always a point
+    Sample end = { waypoints.back(), 0 };
+    samples.push_back(end);
+    return samples;
+}
+
+// picks every PATH_SPACINGth sample and figures out how fast to go there
+static std::vector<path::Point> discretize(const std::vector<Sample>& samples)
+{
+    std::vector<Sample> picked;
+    std::vector<double> speeds;
+    for (size_t i = 0; i < samples.size(); i += PATH_SPACING)
+    {
+        // slow down for the sharpest part of the curve that's coming up
+        double curvature = 0;
+        for (size_t j = i; j < i + PATH_SPACING && j < samples.size(); ++j)
+        {
+            if (samples[j].curvature > curvature)
+            {
+                curvature = samples[j].curvature;
+            }
+        }
+        Sample sample = samples[i];
+        sample.curvature = curvature;
+        picked.push_back(sample);
+    }
+    if (distance(picked.back().position, samples.back().position) > 0.5)
+    {
+        picked.push_back(samples.back());
+    }
+    speeds.resize(picked.size());
+    for (size_t i = 0; i < picked.size(); ++i)
+    {
+        speeds[i] = PATH_MAX_VELOCITY;
+        if (picked[i].curvature > 0 &&
+            PATH_MAX_TURN_RATE / picked[i].curvature < speeds[i])
+        {
+            speeds[i] = PATH_MAX_TURN_RATE / picked[i].curvature;
+        }
+    }
+    // work backwards from stopping at the end, so there's always room to
+    //  slow down in time
+    speeds.back() = 0;
+    for (size_t i = picked.size() - 1; i > 0; --i)
+    {
+        double room = distance(picked[i - 1].position, picked[i].position);
+        double most = sqrt(speeds[i] * speeds[i] + 2 * PATH_MAX_ACCEL * room);
+        if (most < speeds[i - 1])
+        {
+            speeds[i - 1] = most;
+        }
+    }
+    std::vector<path::Point> points;
+    for (size_t i = 0; i < picked.size(); ++i)
+    {
+        path::Point point =
+        {
+            (short) floor(picked[i].position.x + 0.5),
+            (short) floor(picked[i].position.y + 0.5),
+            (short) floor(speeds[i] + 0.5)
+        };
+        points.push_back(point);
+    }
+    return points;
+}
+
+static void read(FILE* input)
+{
+    char text[LINE_SIZE];
+    unsigned int line = 0;
+    // the path that's being read, if any
+    Path* current = NULL;
+    while (fgets(text, sizeof(text), input) != NULL)
+    {
+        ++line;
+        text[strcspn(text, "#\r\n")] = '\0';
+        const char* word = strtok(text, " \t");
+        if (word == NULL)
+        {
+            continue;
+        }
+        if (strcmp(word, "path") == 0)
+        {
+            const char* name = strtok(NULL, " \t");
+            if (current != NULL)
+            {
+                fail(line, "path without end");
+            }
+            if (name == NULL || strlen(name) >= NAME_SIZE)
+            {
+                fail(line, "path needs a name");
+            }
+            paths.push_back(Path());
+            current = &paths.back();
+            strcpy(current->name, name);
+        }
+        else if (strcmp(word, "end") == 0)
+        {
+            if (current == NULL)
+            {
+                fail(line, "end without path");
+            }
+            if (current->waypoints.size() < 2)
+            {
+                fail(line, "paths need at least 2 waypoints");
+            }
+            current = NULL;
+        }
+        else
+        {
+            if (current == NULL)
+            {
+                fail(line, "waypoint outside of a path");
+            }
+            const char* y = strtok(NULL, " \t");
+            char* xEnd;
+            char* yEnd = NULL;
+            Vector waypoint = { strtod(word, &xEnd), 0 };
+            if (y != NULL)
+            {
+                waypoint.y = strtod(y, &yEnd);
+            }
+            if (*xEnd != '\0' || yEnd == NULL || *yEnd != '\0' ||
+                strtok(NULL, " \t") != NULL)
+            {
+                fail(line, "waypoints are 2 numbers");
+            }
+            if (fabs(waypoint.x) > 32767 || fabs(waypoint.y) > 32767)
+            {
+                fail(line, "waypoint out of range");
+            }
+            if (!current->waypoints.empty() &&
+                distance(current->waypoints.back(), waypoint) < 1)
+            {
+                fail(line, "waypoint is on top of the last one");
+            }
+            current->waypoints.push_back(waypoint);
+        }
+    }
+    if (current != NULL)
+    {
+        fail(line, "path without end");
+    }
+    if (paths.empty())
+    {
+        fail(line, "there has to be at least one path");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <paths.txt> <paths.cpp>\n", argv[0]);
+        return 1;
+    }
+    FILE* input = fopen(argv[1], "r");
+    if (input == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    read(input);
+    fclose(input);
+    FILE* output = fopen(argv[2], "w");
+    if (output == NULL)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+    fprintf(output, "// contains the paths from tools/paths.txt, generated by "
+        "tools/pathc\n// don't edit this, edit tools/paths.txt and run make "
+        "in tools/ instead\n\n#include \"main.hpp\"\n");
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        std::vector<path::Point> points = discretize(walk(paths[i].waypoints));
+        if (points.size() > PATH_MAX_POINTS)
+        {
+            fprintf(stderr, "%s is too long\n", paths[i].name);
+            return 1;
+        }
+        // auton::follow() needs the last 2 points to know which way it ends
+        if (points.size() < 2)
+        {
+            fprintf(stderr, "%s is too short\n", paths[i].name);
+            return 1;
+        }
+        fprintf(output, "\n// %s\nstatic const path::Point path%u[] =\n{",
+            paths[i].name, (unsigned int) i);
+        for (size_t j = 0; j < points.size(); ++j)
+        {
+            fprintf(output, "%s{%d, %d, %d}",
+                j == 0 ? "\n    " : j % 4 == 0 ? ",\n    " : ", ",
+                points[j].x, points[j].y, points[j].speed);
+        }
+        fprintf(output, "\n};\n");
+        printf("%s: %u waypoints, %u points, %u bytes\n", paths[i].name,
+            (unsigned int) paths[i].waypoints.size(),
+            (unsigned int) points.size(),
+            (unsigned int) (points.size() * sizeof(path::Point)));
+    }
+    fprintf(output, "\nconst path::Path path::paths[] =\n{\n");
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        fprintf(output, "    {\"%s\", path%u, sizeof(path%u) / "
+            "sizeof(path%u[0])},\n", paths[i].name, (unsigned int) i,
+            (unsigned int) i, (unsigned int) i);
+    }
+    fprintf(output, "};\nconst unsigned int path::pathCount = %u;\n",
+        (unsigned int) paths.size());
+    fclose(output);
+    return 0;
+}
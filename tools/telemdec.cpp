@@ -0,0 +1,164 @@
+// decodes a telemetry log from the robot's flash into a CSV file
+//  (see include/telemetry.hpp)
+//
+// usage: telemdec <input> [output.csv]
+//
+// every record is one row, with the time in ms since the cortex started
+//  and blanks in the columns that don't go with its type
+// the amount of records of each type goes to stderr afterwards
+
+#include <stdio.h>
+
+#include "telemetry.hpp"
+
+static const char* typeNames[telemetry::RECORD_TYPE_COUNT] =
+{
+    "imes", "motors", "joystick", "battery"
+};
+
+static void printHeader(FILE* output)
+{
+    fprintf(output, "time,type");
+    for (unsigned int i = 0; i < TELEMETRY_IMES; ++i)
+    {
+        fprintf(output, ",ime%u", i);
+    }
+    for (unsigned int i = 0; i < TELEMETRY_PORTS; ++i)
+    {
+        fprintf(output, ",port%u", i + 1);
+    }
+    for (unsigned int i = 0; i < TELEMETRY_AXES; ++i)
+    {
+        fprintf(output, ",axis%u", i + 1);
+    }
+    fprintf(output, ",buttons,main,backup,filtered\n");
+}
+
+// prints count empty columns
+static void skip(FILE* output, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        fputc(',', output);
+    }
+}
+
+static void printRecord(FILE* output, const telemetry::Record& record,
+    long time)
+{
+    const unsigned char* payload = record.payload;
+    fprintf(output, "%ld,%s", time, typeNames[record.type]);
+    if (record.type == telemetry::RECORD_IMES)
+    {
+        for (unsigned int i = 0; i < TELEMETRY_IMES; ++i)
+        {
+            fprintf(output, ",%ld", (long) (int) telemetry::getLong(
+                payload + 4 * i));
+        }
+    }
+    else
+    {
+        skip(output, TELEMETRY_IMES);
+    }
+    if (record.type == telemetry::RECORD_MOTORS)
+    {
+        for (unsigned int i = 0; i < TELEMETRY_PORTS; ++i)
+        {
+            fprintf(output, ",%d", (signed char) payload[i]);
+        }
+    }
+    else
+    {
+        skip(output, TELEMETRY_PORTS);
+    }
+    if (record.type == telemetry::RECORD_JOYSTICK)
+    {
+        for (unsigned int i = 0; i < TELEMETRY_AXES; ++i)
+        {
+            fprintf(output, ",%d", (signed char) payload[i]);
+        }
+        fprintf(output, ",0x%04x",
+            telemetry::getShort(payload + TELEMETRY_AXES));
+    }
+    else
+    {
+        skip(output, TELEMETRY_AXES + 1);
+    }
+    if (record.type == telemetry::RECORD_BATTERY)
+    {
+        fprintf(output, ",%u,%u,%u", telemetry::getShort(payload),
+            telemetry::getShort(payload + 2), telemetry::getShort(payload + 4));
+    }
+    else
+    {
+        skip(output, 3);
+    }
+    fputc('\n', output);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2 && argc != 3)
+    {
+        fprintf(stderr, "usage: %s <input> [output.csv]\n", argv[0]);
+        return 1;
+    }
+    FILE* input = fopen(argv[1], "rb");
+    if (input == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    unsigned char header[TELEMETRY_HEADER_SIZE];
+    if (fread(header, 1, TELEMETRY_HEADER_SIZE, input) !=
+        TELEMETRY_HEADER_SIZE || header[0] != TELEMETRY_MAGIC[0] ||
+        header[1] != TELEMETRY_MAGIC[1] || header[2] != TELEMETRY_MAGIC[2] ||
+        header[3] != TELEMETRY_MAGIC[3])
+    {
+        fprintf(stderr, "%s isn't a telemetry log\n", argv[1]);
+        return 1;
+    }
+    FILE* output = stdout;
+    if (argc == 3)
+    {
+        output = fopen(argv[2], "w");
+        if (output == NULL)
+        {
+            perror(argv[2]);
+            return 1;
+        }
+    }
+    printHeader(output);
+    // the deltas add up to the time of each record
+    long time = (long) telemetry::getLong(header + 4);
+    unsigned long counts[telemetry::RECORD_TYPE_COUNT] = {0};
+    unsigned long unknown = 0;
+    unsigned char bytes[TELEMETRY_RECORD_SIZE];
+    while (fread(bytes, 1, TELEMETRY_RECORD_SIZE, input) ==
+        TELEMETRY_RECORD_SIZE)
+    {
+        telemetry::Record record = telemetry::decode(bytes);
+        time += record.delta;
+        if (record.type >= telemetry::RECORD_TYPE_COUNT)
+        {
+            ++unknown;
+            continue;
+        }
+        ++counts[record.type];
+        printRecord(output, record, time);
+    }
+    fclose(input);
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+    for (unsigned int i = 0; i < telemetry::RECORD_TYPE_COUNT; ++i)
+    {
+        fprintf(stderr, "%s: %lu\n", typeNames[i], counts[i]);
+    }
+    if (unknown > 0)
+    {
+        fprintf(stderr, "unknown: %lu\n", unknown);
+    }
+    return 0;
+}